@@ -0,0 +1,166 @@
+#include "AIScheduler.h"
+#include "JobSystem.h"
+#include <string>
+#include <vector>
+
+#define AI_BLOCK			256				// Objects per job, the slices and the budget are whole blocks
+#define AI_SLICE			(16 * AI_BLOCK)	// Objects a task runs before the next one gets its turn, the same on any number of threads
+#define AI_DEFAULT_BUDGET	8192			// Objects per update, far more missiles than a game fires
+
+static_assert(GAME_OBJ_CHUNK_SIZE % AI_BLOCK == 0, "a block must not cross a chunk");
+
+// -------------------------------------------
+// Tasks
+// -------------------------------------------
+
+struct AITask
+{
+	std::string		name;
+	int				type;
+	AITaskFunc		func;
+
+	int				cursor;				// Next object of the bucket, at the start of a block
+	int				visited;			// Objects visited in the current update
+	long			wrapUpdate;			// Update in which the last pass ended
+	int				passLength;			// Updates the last pass took, >= 1
+	std::vector<long>	blockUpdate;	// Update in which each block of the bucket was last visited
+};
+
+static std::vector<AITask>	sTask;
+static int			sBudget = AI_DEFAULT_BUDGET;	// Objects per update
+static long			sUpdate;						// AISchedulerRun() calls
+static int			sFirstTask;						// Task that starts the next update, they take turns
+
+
+int AISchedulerAdd(const char* name, int type, const AITaskFunc& func)
+{
+	AITask task;
+	task.name = name;
+	task.type = type;
+	task.func = func;
+	task.cursor = 0;
+	task.visited = 0;
+	task.wrapUpdate = sUpdate;
+	task.passLength = 1;
+
+	sTask.push_back(task);
+	return (int)sTask.size() - 1;
+}
+
+void AISchedulerRemoveAll()
+{
+	sTask.clear();
+	sFirstTask = 0;
+}
+
+void AISchedulerReset()
+{
+	for (size_t t = 0; t < sTask.size(); t++) {
+		sTask[t].cursor = 0;
+		sTask[t].wrapUpdate = sUpdate;
+		sTask[t].passLength = 1;
+		sTask[t].blockUpdate.clear();
+	}
+	sFirstTask = 0;
+}
+
+void AISchedulerSetBudget(int numObject)
+{
+	sBudget = (numObject < 0) ? 0 : numObject;
+}
+
+int AISchedulerGetBudget()
+{
+	return sBudget;
+}
+
+int AISchedulerPassLength(int task)
+{
+	// the current pass when it is already longer than the last one
+	return glm::max(sTask[task].passLength, (int)(sUpdate - sTask[task].wrapUpdate));
+}
+
+
+// -------------------------------------------
+// Run
+// -------------------------------------------
+
+// func on [index, index + num) of the bucket, one block per job, index at the start of a block
+//	- numTick of a block = the updates since it was last visited, a block never visited gets 1
+static void runSlice(AITask& task, int index, int num)
+{
+	int numBlock = (num + AI_BLOCK - 1) / AI_BLOCK;
+	int lastBlock = (index + num - 1) / AI_BLOCK;
+	if ((int)task.blockUpdate.size() <= lastBlock)
+		task.blockUpdate.resize(lastBlock + 1, sUpdate - 1);
+
+	JobParallelFor(numBlock, 1, [&](int begin, int end) {
+		for (int b = begin; b < end; b++) {
+			int first = index + b * AI_BLOCK;
+			int c = first >> GAME_OBJ_CHUNK_SHIFT;
+			int count = glm::min(AI_BLOCK, index + num - first);
+
+			long& visit = task.blockUpdate[first / AI_BLOCK];
+			int numTick = (int)(sUpdate - visit);
+			visit = sUpdate;
+
+			task.func(GameObjChunkData(task.type, c), first & (GAME_OBJ_CHUNK_SIZE - 1), count, numTick);
+		}
+	});
+}
+
+void AISchedulerRun()
+{
+	int numTask = (int)sTask.size();
+	int left = sBudget;
+
+	sUpdate++;
+	for (int t = 0; t < numTask; t++) {
+		sTask[t].visited = 0;
+	}
+
+	// one slice of each task in turn, the first slice of a task does not look at the budget
+	bool progress = true;
+	bool spent = false;
+	for (int round = 0; progress && !spent; round++) {
+		progress = false;
+
+		for (int k = 0; k < numTask && !spent; k++) {
+			AITask& task = sTask[(sFirstTask + k) % numTask];
+			int count = GameObjCount(task.type);
+			if (task.cursor >= count)
+				task.cursor = 0;
+			if (task.visited >= count)
+				continue;
+
+			// a slice stays inside a chunk, and inside the budget
+			int num = glm::min(AI_SLICE, count - task.visited);
+			if (sBudget > 0) {
+				if (round > 0 && left <= 0) {
+					spent = true;
+					break;
+				}
+				num = glm::min(num, glm::max(left, 1));
+			}
+			num = glm::min(num, GAME_OBJ_CHUNK_SIZE - (task.cursor & (GAME_OBJ_CHUNK_SIZE - 1)));
+
+			// whole blocks, so the next slice starts at a block too
+			num = glm::min((num + AI_BLOCK - 1) / AI_BLOCK * AI_BLOCK, count - task.cursor);
+
+			runSlice(task, task.cursor, num);
+			left -= num;
+
+			task.cursor += num;
+			task.visited += num;
+			if (task.cursor >= count) {
+				task.cursor = 0;
+				task.passLength = glm::max((int)(sUpdate - task.wrapUpdate), 1);
+				task.wrapUpdate = sUpdate;
+			}
+			progress = true;
+		}
+	}
+
+	if (numTask > 0)
+		sFirstTask = (sFirstTask + 1) % numTask;
+}
@@ -0,0 +1,35 @@
+#ifndef AI_SCHEDULER
+#define AI_SCHEDULER
+
+#include <functional>
+#include "GameObj.h"
+
+// -------------------------------------------
+// Time-sliced AI updates
+//	- a task updates the objects of one bucket (missile steering, enemy logic, ...)
+//	- AISchedulerRun() runs the tasks one slice of objects at a time, in turn, until the budget of
+//	  the update is spent or every object had its turn, the next update goes on where it stopped
+//	- the budget is a number of objects per update, not a time, so which objects are visited does
+//	  not depend on the speed of the machine and a replay plays the same; it is rounded up to
+//	  whole blocks of 256 objects
+//	- every task gets at least one slice per update, so a full pass always ends eventually
+//	- func(obj, first, num, numTick): the objects [first, first + num) of obj, numTick = the updates
+//	  since this block of objects was last visited, scale the time step by it
+//	- the objects of a slice are spread over the job system, func runs on several threads at once
+//	- the order of a bucket changes when objects are destroyed, so an object may be skipped or
+//	  visited twice in a pass
+// -------------------------------------------
+
+typedef std::function<void(const GameObjArrays&, int, int, int)> AITaskFunc;
+
+int  AISchedulerAdd(const char* name, int type, const AITaskFunc& func);	// Return the task index
+void AISchedulerRemoveAll();
+void AISchedulerReset();				// Start every task again from the first object, on level restart
+void AISchedulerSetBudget(int numObject);	// Objects per update, 0 = no budget, every object every update
+int  AISchedulerGetBudget();
+
+void AISchedulerRun();					// Once per update
+int  AISchedulerPassLength(int task);	// Updates a full pass of the task takes, the current pass once it is longer than the last
+
+
+#endif // AI_SCHEDULER
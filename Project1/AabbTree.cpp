@@ -0,0 +1,163 @@
+#include "AabbTree.h"
+#include <box2d/b2_dynamic_tree.h>
+#include <vector>
+
+#define AABB_TREE_PAD			1.0f			// Added to the boxes, covers the rounding of position +- scale
+#define AABB_TREE_SLOT_MASK		((1 << GAME_OBJ_SLOT_BITS) - 1)
+
+// -------------------------------------------
+// Proxies
+// -------------------------------------------
+
+struct AabbTreeProxy
+{
+	GameObjHandle	handle;				// GAME_OBJ_HANDLE_NONE = the proxy id is free
+	int				index;				// In the bucket
+	glm::vec2		position;
+	glm::vec2		scale;
+	unsigned int	stamp;				// Update that last saw the object
+};
+
+struct AabbTree
+{
+	int							type;
+	float						margin;
+	b2DynamicTree				tree;
+
+	std::vector<AabbTreeProxy>	proxy;			// By proxy id
+	std::vector<int>			live;			// Proxy ids in use
+	std::vector<int>			slotProxy;		// Proxy of each handle slot, checked against the handle
+	unsigned int				stamp;
+	int							numMove;
+};
+
+static b2AABB makeAABB(glm::vec2 position, glm::vec2 extent)
+{
+	b2AABB aabb;
+	aabb.lowerBound.Set(position.x - extent.x, position.y - extent.y);
+	aabb.upperBound.Set(position.x + extent.x, position.y + extent.y);
+	return aabb;
+}
+
+AabbTree* AabbTreeCreate(int type, float margin)
+{
+	AabbTree* pTree = new AabbTree;
+	pTree->type = type;
+	pTree->margin = margin;
+	pTree->stamp = 0;
+	pTree->numMove = 0;
+	return pTree;
+}
+
+void AabbTreeDestroy(AabbTree* pTree)
+{
+	delete pTree;
+}
+
+void AabbTreeUpdate(AabbTree* pTree)
+{
+	pTree->stamp++;
+	pTree->numMove = 0;
+
+	for (int c = 0; c < GameObjNumChunk(pTree->type); c++) {
+		const GameObjArrays& obj = GameObjChunkData(pTree->type, c);
+		int chunkCount = GameObjChunkCount(pTree->type, c);
+
+		for (int i = 0; i < chunkCount; i++) {
+			GameObjHandle handle = obj.handle[i];
+			int slot = handle & AABB_TREE_SLOT_MASK;
+			if (slot >= (int)pTree->slotProxy.size())
+				pTree->slotProxy.resize(slot + 1, -1);
+
+			glm::vec2 extent = glm::abs(obj.scale[i]) + AABB_TREE_PAD;
+			b2AABB aabb = makeAABB(obj.position[i], extent);
+
+			int id = pTree->slotProxy[slot];
+			if (id >= 0 && id < (int)pTree->proxy.size() && pTree->proxy[id].handle == handle) {
+				// still inside its fat box, the tree does not change
+				if (!pTree->tree.GetFatAABB(id).Contains(aabb)) {
+					glm::vec2 move = obj.position[i] - obj.prevPosition[i];
+					pTree->tree.MoveProxy(id, makeAABB(obj.position[i], extent + pTree->margin), b2Vec2(move.x, move.y));
+					pTree->numMove++;
+				}
+			}
+			else {
+				id = pTree->tree.CreateProxy(makeAABB(obj.position[i], extent + pTree->margin), NULL);
+				if (id >= (int)pTree->proxy.size())
+					pTree->proxy.resize(id + 1);
+				pTree->slotProxy[slot] = id;
+				pTree->live.push_back(id);
+				pTree->proxy[id].handle = handle;
+			}
+
+			AabbTreeProxy& proxy = pTree->proxy[id];
+			proxy.index = (c << GAME_OBJ_CHUNK_SHIFT) + i;
+			proxy.position = obj.position[i];
+			proxy.scale = obj.scale[i];
+			proxy.stamp = pTree->stamp;
+		}
+	}
+
+	// the objects that are gone give their proxy back
+	int num = 0;
+	for (size_t n = 0; n < pTree->live.size(); n++) {
+		int id = pTree->live[n];
+		if (pTree->proxy[id].stamp == pTree->stamp) {
+			pTree->live[num++] = id;
+		}
+		else {
+			pTree->tree.DestroyProxy(id);
+			pTree->proxy[id].handle = GAME_OBJ_HANDLE_NONE;
+		}
+	}
+	pTree->live.resize(num);
+}
+
+int AabbTreeCount(const AabbTree* pTree)
+{
+	return (int)pTree->live.size();
+}
+
+int AabbTreeNumMove(const AabbTree* pTree)
+{
+	return pTree->numMove;
+}
+
+int AabbTreeHeight(const AabbTree* pTree)
+{
+	return pTree->tree.GetHeight();
+}
+
+
+// -------------------------------------------
+// Queries
+// -------------------------------------------
+
+// b2DynamicTree::Query() callback, the exact box test on the proxies whose fat box overlaps
+struct AabbTreeQuery
+{
+	const AabbTree*		pTree;
+	glm::vec2			pos;
+	glm::vec2			halfSize;
+	std::vector<int>*	pOutIndex;
+	int					numFound;
+
+	bool QueryCallback(int32 id)
+	{
+		const AabbTreeProxy& proxy = pTree->proxy[id];
+		glm::vec2 d = glm::abs(proxy.position - pos);
+		glm::vec2 extent = proxy.scale + halfSize;
+		if (d.x <= extent.x && d.y <= extent.y) {
+			pOutIndex->push_back(proxy.index);
+			numFound++;
+		}
+		return true;
+	}
+};
+
+int AabbTreeOverlap(const AabbTree* pTree, glm::vec2 pos, glm::vec2 halfSize, std::vector<int>& outIndex)
+{
+	AabbTreeQuery query = { pTree, pos, halfSize, &outIndex, 0 };
+	pTree->tree.Query(&query, makeAABB(pos, halfSize));
+	return query.numFound;
+}
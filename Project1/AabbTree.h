@@ -0,0 +1,34 @@
+#ifndef AABB_TREE
+#define AABB_TREE
+
+#include <vector>
+#include "GameObj.h"
+
+// -------------------------------------------
+// Box2D dynamic AABB tree (b2DynamicTree) over the objects of one bucket
+//	- AabbTreeUpdate() keeps one proxy per object from one update to the next: new objects get a
+//	  proxy, stale handles lose theirs, and an object is only reinserted when its box leaves the fat
+//	  box of its proxy, its box grown by margin and by the last move (Box2D extends it forward)
+//	- the box of an object is its position +- its scale, the extent the collision broadphase tests
+//	- the queries only read the tree, they can run on several threads at once, not during an update
+//	- the tree comes from the Box2D 2.4.1 sources in lib/box2d/src, built by the Visual Studio project
+//	  and by the box2d library of CMakeLists.txt
+// -------------------------------------------
+
+struct AabbTree;
+
+AabbTree* AabbTreeCreate(int type, float margin);
+void AabbTreeDestroy(AabbTree* pTree);
+
+// Read the bucket, once per update before the queries
+void AabbTreeUpdate(AabbTree* pTree);
+int  AabbTreeCount(const AabbTree* pTree);
+int  AabbTreeNumMove(const AabbTree* pTree);		// Proxies reinserted by the last update, new ones not counted
+int  AabbTreeHeight(const AabbTree* pTree);
+
+// Append to outIndex the objects whose box overlaps pos +- halfSize, return how many were appended
+//	- the index of an object in its bucket at the last update, chunk = index >> GAME_OBJ_CHUNK_SHIFT
+int AabbTreeOverlap(const AabbTree* pTree, glm::vec2 pos, glm::vec2 halfSize, std::vector<int>& outIndex);
+
+
+#endif // AABB_TREE
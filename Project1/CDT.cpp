@@ -23,6 +23,10 @@ int			cdt_rendermode;
 float		cdt_tranparency;
 glm::mat4	cdt_MVP;
 CDTTex		cdt_blanktex;
+bool		cdt_headless;		// No GL context, the mesh/texture/render functions do nothing
+
+// GAME_HEADLESS: the build without GL (the headless target of CMakeLists.txt), the GL calls are
+// compiled out and CDTInit() is CDTInitHeadless()
 
 
 // -------------------------------------------
@@ -31,8 +35,10 @@ CDTTex		cdt_blanktex;
 
 void CDTInit(int width, int height)
 {
-	srand(time(NULL));
-
+#ifdef GAME_HEADLESS
+	CDTInitHeadless(width, height);
+#else
+	cdt_headless = false;
 	cdt_width = width;
 	cdt_height = height;
 
@@ -54,13 +60,29 @@ void CDTInit(int width, int height)
 	cdt_camdegree = 0.0f;
 	cdt_ProjectionMatrix = glm::ortho(-(cdt_width/2)*cdt_camzoom, (cdt_width/2)*cdt_camzoom, -(cdt_height/2)*cdt_camzoom, (cdt_height/2)*cdt_camzoom, -10.0f, 10.0f);
 	cdt_ViewMatrix = glm::lookAt(cdt_campos, cdt_campos + cdt_camdir, cdt_camup);
+#endif
+}
 
+void CDTInitHeadless(int width, int height)
+{
+	cdt_headless = true;
+	cdt_width = width;
+	cdt_height = height;
+	cdt_tranparency = 1.0f;
+
+	// the camera is still used by the game logic (zoom keys)
+	ResetCam();
 }
 
 void CDTShutdown()
 {
+#ifndef GAME_HEADLESS
+	if (cdt_headless)
+		return;
+
 	glDeleteProgram(cdt_programID);
 	TextureUnload(cdt_blanktex);
+#endif
 }
 
 int  GetWindowWidth()
@@ -82,6 +104,12 @@ CDTMesh CreateMesh(std::vector<CDTVertex> in_vertex)
 	CDTMesh aMesh;
 	aMesh.vertex = in_vertex;
 
+	aMesh.vaoHandle = 0;
+	aMesh.vertexBuffer = 0;
+#ifndef GAME_HEADLESS
+	if (cdt_headless)
+		return aMesh;
+
 	glGenBuffers(1, &aMesh.vertexBuffer);
 	glBindBuffer(GL_ARRAY_BUFFER, aMesh.vertexBuffer);
 	glBufferData(GL_ARRAY_BUFFER, aMesh.vertex.size() * sizeof(CDTVertex), &aMesh.vertex[0].x, GL_STATIC_DRAW);
@@ -97,22 +125,31 @@ CDTMesh CreateMesh(std::vector<CDTVertex> in_vertex)
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(CDTVertex), BUFFER_OFFSET(24));
 	
 	glBindVertexArray(0);
-	
+#endif
 	return aMesh;
 }
 
 void DrawMesh(CDTMesh &mesh)
 {
+#ifndef GAME_HEADLESS
+	if (cdt_headless)
+		return;
+
 	glBindVertexArray(mesh.vaoHandle);
 	glDrawArrays(GL_TRIANGLES, 0, mesh.vertex.size());
 
 	glBindVertexArray(0);
+#endif
 }
 
 void UnloadMesh(CDTMesh &mesh)
 {
-	glDeleteBuffers(1, &mesh.vertexBuffer);
-	glDeleteVertexArrays(1, &mesh.vaoHandle);
+#ifndef GAME_HEADLESS
+	if (!cdt_headless){
+		glDeleteBuffers(1, &mesh.vertexBuffer);
+		glDeleteVertexArrays(1, &mesh.vaoHandle);
+	}
+#endif
 
 	mesh.vertex.clear();
 }
@@ -123,11 +160,17 @@ void UnloadMesh(CDTMesh &mesh)
 
 CDTTex TextureLoad(const char* filename)
 {
+#ifdef GAME_HEADLESS
+	return 0;
+#else
 	CDTTex aTex;
 
 	GLubyte*	pData;
 	int			texWidth, texHeight, channels;
 
+	if (cdt_headless)
+		return 0;
+
 	pData = SOIL_load_image(filename, &texWidth, &texHeight, &channels, SOIL_LOAD_AUTO);
 
 	glGenTextures(1, &aTex);
@@ -144,12 +187,18 @@ CDTTex TextureLoad(const char* filename)
 	SOIL_free_image_data(pData);
 
 	return aTex;
+#endif
 }
 
 
 void TextureUnload(CDTTex &tex)
 {
+#ifndef GAME_HEADLESS
+	if (cdt_headless)
+		return;
+
 	glDeleteTextures(1, &tex);
+#endif
 }
 
 // -------------------------------------------
@@ -224,8 +273,23 @@ void ResetCam()
 // CDT Renderer function
 // -------------------------------------------
 
+void ClearScreen(float r, float g, float b)
+{
+#ifndef GAME_HEADLESS
+	if (cdt_headless)
+		return;
+
+	glClearColor(r, g, b, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+#endif
+}
+
 void SetRenderMode(int mode, float alpha)
 {
+#ifndef GAME_HEADLESS
+	if (cdt_headless)
+		return;
+
 	glViewport(0, 0, cdt_width, cdt_height);
 	glUseProgram(cdt_programID);
 
@@ -235,21 +299,31 @@ void SetRenderMode(int mode, float alpha)
 	// default setting
 	SetTexture(cdt_blanktex, 0.0f, 0.0f);
 	SetTransform(glm::mat4(1.0f));
-
+#endif
 }
 
 void SetTexture(CDTTex tex, float offsetX, float offsetY)
 {
+#ifndef GAME_HEADLESS
+	if (cdt_headless)
+		return;
+
 	glUniform1f(glGetUniformLocation(cdt_programID, "offsetX"), offsetX);
 	glUniform1f(glGetUniformLocation(cdt_programID, "offsetY"), offsetY);
 
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, tex);
 	glUniform1i(glGetUniformLocation(cdt_programID, "tex1"), 0);
+#endif
 }
 
 void SetTransform(const glm::mat4 &modelMat)
 {
 	cdt_MVP = cdt_ProjectionMatrix * cdt_ViewMatrix * modelMat;
+#ifndef GAME_HEADLESS
+	if (cdt_headless)
+		return;
+
 	glUniformMatrix4fv(glGetUniformLocation(cdt_programID, "MVP"), 1, GL_FALSE, &cdt_MVP[0][0]);
+#endif
 }
@@ -56,6 +56,7 @@ typedef GLuint CDTTex;
 // -------------------------------------------
 
 void CDTInit(int width, int height);
+void CDTInitHeadless(int width, int height);	// No GL context: the window size and the camera only, the mesh/texture/render functions do nothing
 void CDTShutdown();
 int  GetWindowWidth();
 int  GetWindowHeight();
@@ -92,6 +93,7 @@ void ResetCam();
 // CDT Renderer function
 // -------------------------------------------
 
+void ClearScreen(float r, float g, float b);
 void SetRenderMode(int mode, float alpha);
 void SetTexture(CDTTex tex, float offsetX, float offsetY);
 void SetTransform(const glm::mat4 &modelMat);
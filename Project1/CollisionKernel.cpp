@@ -0,0 +1,304 @@
+#include "CollisionKernel.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define KERNEL_TARGET_AVX2
+#define KERNEL_TARGET_AVX512
+#else
+#define KERNEL_TARGET_AVX2		__attribute__((target("avx2")))
+#define KERNEL_TARGET_AVX512	__attribute__((target("avx512f")))
+#endif
+#endif
+
+enum KERNEL_LEVEL
+{
+	KERNEL_SCALAR = 0,
+	KERNEL_AVX2,
+	KERNEL_AVX512,
+
+	NUM_KERNEL
+};
+static const char*	sKernelName[NUM_KERNEL] = { "scalar", "AVX2", "AVX-512" };
+
+
+// -------------------------------------------
+// Scalar
+//	- written out float by float, the SIMD versions do the same operations in the same order
+// -------------------------------------------
+
+void CollisionPointCirclesScalar(glm::vec2 p, const float* x, const float* y, const float* radius, int count, uint32_t* outMask)
+{
+	memset(outMask, 0, ((count + 31) / 32) * sizeof(uint32_t));
+
+	for (int n = 0; n < count; n++) {
+		float dx = x[n] - p.x;
+		float dy = y[n] - p.y;
+		if (dx * dx + dy * dy <= radius[n] * radius[n])
+			outMask[n >> 5] |= 1u << (n & 31);
+	}
+}
+
+void CollisionCapsuleCirclesScalar(glm::vec2 p, glm::vec2 dir, float halfLength, float capsuleRadius,
+	const float* x, const float* y, const float* radius, int count, uint32_t* outMask)
+{
+	memset(outMask, 0, ((count + 31) / 32) * sizeof(uint32_t));
+
+	for (int n = 0; n < count; n++) {
+		float dx = x[n] - p.x;
+		float dy = y[n] - p.y;
+
+		// closest point of the segment
+		float t = dx * dir.x + dy * dir.y;
+		t = glm::min(glm::max(t, -halfLength), halfLength);
+		dx = dx - t * dir.x;
+		dy = dy - t * dir.y;
+
+		float reach = radius[n] + capsuleRadius;
+		if (dx * dx + dy * dy <= reach * reach)
+			outMask[n >> 5] |= 1u << (n & 31);
+	}
+}
+
+
+// -------------------------------------------
+// SIMD
+//	- the circles that do not fill a register go through the scalar version
+// -------------------------------------------
+
+#if defined(KERNEL_X86)
+
+// Scalar on [first, count), the circles after the last full register
+//	- fewer than 16 from a multiple of 8, their bits fit in the word of first
+static void scalarTail(glm::vec2 p, glm::vec2 dir, float halfLength, float capsuleRadius, bool capsule,
+	const float* x, const float* y, const float* radius, int first, int count, uint32_t* outMask)
+{
+	uint32_t tail;
+	if (capsule)
+		CollisionCapsuleCirclesScalar(p, dir, halfLength, capsuleRadius, x + first, y + first, radius + first, count - first, &tail);
+	else
+		CollisionPointCirclesScalar(p, x + first, y + first, radius + first, count - first, &tail);
+
+	if ((first & 31) == 0)
+		outMask[first >> 5] = tail;
+	else
+		outMask[first >> 5] |= tail << (first & 31);
+}
+
+KERNEL_TARGET_AVX2
+static void pointCirclesAVX2(glm::vec2 p, const float* x, const float* y, const float* radius, int count, uint32_t* outMask)
+{
+	__m256 px = _mm256_set1_ps(p.x);
+	__m256 py = _mm256_set1_ps(p.y);
+
+	// 8 circles per step
+	int n = 0;
+	for (; n + 8 <= count; n += 8) {
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + n), px);
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + n), py);
+		__m256 r = _mm256_loadu_ps(radius + n);
+		__m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		uint32_t hit = (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(r, r), _CMP_LE_OQ));
+
+		if ((n & 31) == 0)
+			outMask[n >> 5] = hit;
+		else
+			outMask[n >> 5] |= hit << (n & 31);
+	}
+
+	if (n < count)
+		scalarTail(p, glm::vec2(0.0f), 0.0f, 0.0f, false, x, y, radius, n, count, outMask);
+}
+
+KERNEL_TARGET_AVX2
+static void capsuleCirclesAVX2(glm::vec2 p, glm::vec2 dir, float halfLength, float capsuleRadius,
+	const float* x, const float* y, const float* radius, int count, uint32_t* outMask)
+{
+	__m256 px = _mm256_set1_ps(p.x);
+	__m256 py = _mm256_set1_ps(p.y);
+	__m256 dirX = _mm256_set1_ps(dir.x);
+	__m256 dirY = _mm256_set1_ps(dir.y);
+	__m256 hMax = _mm256_set1_ps(halfLength);
+	__m256 hMin = _mm256_set1_ps(-halfLength);
+	__m256 cr = _mm256_set1_ps(capsuleRadius);
+
+	int n = 0;
+	for (; n + 8 <= count; n += 8) {
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + n), px);
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + n), py);
+
+		__m256 t = _mm256_add_ps(_mm256_mul_ps(dx, dirX), _mm256_mul_ps(dy, dirY));
+		t = _mm256_min_ps(_mm256_max_ps(t, hMin), hMax);
+		dx = _mm256_sub_ps(dx, _mm256_mul_ps(t, dirX));
+		dy = _mm256_sub_ps(dy, _mm256_mul_ps(t, dirY));
+
+		__m256 reach = _mm256_add_ps(_mm256_loadu_ps(radius + n), cr);
+		__m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		uint32_t hit = (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(reach, reach), _CMP_LE_OQ));
+
+		if ((n & 31) == 0)
+			outMask[n >> 5] = hit;
+		else
+			outMask[n >> 5] |= hit << (n & 31);
+	}
+
+	if (n < count)
+		scalarTail(p, dir, halfLength, capsuleRadius, true, x, y, radius, n, count, outMask);
+}
+
+// a * b with the rounding spelled out, the compiler cannot fuse it into an FMA the scalar version does not do
+#define mul512(a, b)	_mm512_mul_round_ps(a, b, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+
+KERNEL_TARGET_AVX512
+static void pointCirclesAVX512(glm::vec2 p, const float* x, const float* y, const float* radius, int count, uint32_t* outMask)
+{
+	__m512 px = _mm512_set1_ps(p.x);
+	__m512 py = _mm512_set1_ps(p.y);
+
+	// 16 circles per step
+	int n = 0;
+	for (; n + 16 <= count; n += 16) {
+		__m512 dx = _mm512_sub_ps(_mm512_loadu_ps(x + n), px);
+		__m512 dy = _mm512_sub_ps(_mm512_loadu_ps(y + n), py);
+		__m512 r = _mm512_loadu_ps(radius + n);
+		__m512 d2 = _mm512_add_ps(mul512(dx, dx), mul512(dy, dy));
+		uint32_t hit = (uint32_t)_mm512_cmp_ps_mask(d2, mul512(r, r), _CMP_LE_OQ);
+
+		if ((n & 31) == 0)
+			outMask[n >> 5] = hit;
+		else
+			outMask[n >> 5] |= hit << 16;
+	}
+
+	if (n < count)
+		scalarTail(p, glm::vec2(0.0f), 0.0f, 0.0f, false, x, y, radius, n, count, outMask);
+}
+
+KERNEL_TARGET_AVX512
+static void capsuleCirclesAVX512(glm::vec2 p, glm::vec2 dir, float halfLength, float capsuleRadius,
+	const float* x, const float* y, const float* radius, int count, uint32_t* outMask)
+{
+	__m512 px = _mm512_set1_ps(p.x);
+	__m512 py = _mm512_set1_ps(p.y);
+	__m512 dirX = _mm512_set1_ps(dir.x);
+	__m512 dirY = _mm512_set1_ps(dir.y);
+	__m512 hMax = _mm512_set1_ps(halfLength);
+	__m512 hMin = _mm512_set1_ps(-halfLength);
+	__m512 cr = _mm512_set1_ps(capsuleRadius);
+
+	int n = 0;
+	for (; n + 16 <= count; n += 16) {
+		__m512 dx = _mm512_sub_ps(_mm512_loadu_ps(x + n), px);
+		__m512 dy = _mm512_sub_ps(_mm512_loadu_ps(y + n), py);
+
+		__m512 t = _mm512_add_ps(mul512(dx, dirX), mul512(dy, dirY));
+		t = _mm512_min_ps(_mm512_max_ps(t, hMin), hMax);
+		dx = _mm512_sub_ps(dx, mul512(t, dirX));
+		dy = _mm512_sub_ps(dy, mul512(t, dirY));
+
+		__m512 reach = _mm512_add_ps(_mm512_loadu_ps(radius + n), cr);
+		__m512 d2 = _mm512_add_ps(mul512(dx, dx), mul512(dy, dy));
+		uint32_t hit = (uint32_t)_mm512_cmp_ps_mask(d2, mul512(reach, reach), _CMP_LE_OQ);
+
+		if ((n & 31) == 0)
+			outMask[n >> 5] = hit;
+		else
+			outMask[n >> 5] |= hit << 16;
+	}
+
+	if (n < count)
+		scalarTail(p, dir, halfLength, capsuleRadius, true, x, y, radius, n, count, outMask);
+}
+
+// Best level of the CPU, the OS must also save the registers (XCR0)
+static int detectLevel()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return KERNEL_SCALAR;
+
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx)
+		return KERNEL_SCALAR;
+
+	unsigned long long xcr0 = _xgetbv(0);
+	__cpuidex(info, 7, 0);
+	if ((info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6)
+		return KERNEL_AVX512;
+	if ((info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6)
+		return KERNEL_AVX2;
+	return KERNEL_SCALAR;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return KERNEL_AVX512;
+	if (__builtin_cpu_supports("avx2"))
+		return KERNEL_AVX2;
+	return KERNEL_SCALAR;
+#endif
+}
+
+#else
+
+static int detectLevel()
+{
+	return KERNEL_SCALAR;
+}
+
+#endif
+
+
+// -------------------------------------------
+// Dispatch
+// -------------------------------------------
+
+static int sBestLevel = detectLevel();
+static int sLevel = sBestLevel;
+
+void CollisionPointCircles(glm::vec2 p, const float* x, const float* y, const float* radius, int count, uint32_t* outMask)
+{
+#if defined(KERNEL_X86)
+	if (sLevel == KERNEL_AVX512)
+		pointCirclesAVX512(p, x, y, radius, count, outMask);
+	else if (sLevel == KERNEL_AVX2)
+		pointCirclesAVX2(p, x, y, radius, count, outMask);
+	else
+#endif
+		CollisionPointCirclesScalar(p, x, y, radius, count, outMask);
+}
+
+void CollisionCapsuleCircles(glm::vec2 p, glm::vec2 dir, float halfLength, float capsuleRadius,
+	const float* x, const float* y, const float* radius, int count, uint32_t* outMask)
+{
+#if defined(KERNEL_X86)
+	if (sLevel == KERNEL_AVX512)
+		capsuleCirclesAVX512(p, dir, halfLength, capsuleRadius, x, y, radius, count, outMask);
+	else if (sLevel == KERNEL_AVX2)
+		capsuleCirclesAVX2(p, dir, halfLength, capsuleRadius, x, y, radius, count, outMask);
+	else
+#endif
+		CollisionCapsuleCirclesScalar(p, dir, halfLength, capsuleRadius, x, y, radius, count, outMask);
+}
+
+const char* CollisionKernelName()
+{
+	return sKernelName[sLevel];
+}
+
+bool CollisionKernelSelect(const char* name)
+{
+	for (int level = 0; level <= sBestLevel; level++) {
+		if (strcmp(name, sKernelName[level]) == 0) {
+			sLevel = level;
+			return true;
+		}
+	}
+	return false;
+}
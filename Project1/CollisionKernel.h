@@ -0,0 +1,35 @@
+#ifndef COLLISION_KERNEL
+#define COLLISION_KERNEL
+
+#include <stdint.h>
+#include "GameObj.h"
+
+// -------------------------------------------
+// Batched narrow phase, one projectile against many circles
+//	- the circles are SoA: x[n], y[n], radius[n], any count, no alignment needed
+//	- outMask gets one bit per circle, bit n % 32 of outMask[n / 32] = circle n is hit, (count + 31) / 32 words
+//	- the SIMD version is picked at run time from cpuid: AVX-512 16 circles per instruction, AVX2 8,
+//	  scalar otherwise; the SIMD functions are compiled for their instruction set one by one, the
+//	  project needs no /arch or -m flag
+//	- the scalar version is always built, it is the reference: same operations in the same order,
+//	  the masks are the same bit for bit
+// -------------------------------------------
+
+// Point p against the circles: |c - p|^2 <= r^2
+void CollisionPointCircles(glm::vec2 p, const float* x, const float* y, const float* radius, int count, uint32_t* outMask);
+void CollisionPointCirclesScalar(glm::vec2 p, const float* x, const float* y, const float* radius, int count, uint32_t* outMask);
+
+// Capsule against the circles, the segment p +- dir * halfLength (unit dir) grown by capsuleRadius
+//	- a segment is a capsule of radius 0
+void CollisionCapsuleCircles(glm::vec2 p, glm::vec2 dir, float halfLength, float capsuleRadius,
+	const float* x, const float* y, const float* radius, int count, uint32_t* outMask);
+void CollisionCapsuleCirclesScalar(glm::vec2 p, glm::vec2 dir, float halfLength, float capsuleRadius,
+	const float* x, const float* y, const float* radius, int count, uint32_t* outMask);
+
+// "AVX-512", "AVX2" or "scalar"
+const char* CollisionKernelName();
+// Use the named version instead of the best one, false when the CPU does not have it, for the benchmark
+bool CollisionKernelSelect(const char* name);
+
+
+#endif // COLLISION_KERNEL
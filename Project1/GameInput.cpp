@@ -0,0 +1,181 @@
+#include "GameInput.h"
+#include "system.h"
+#include <string.h>
+#include <string>
+#include <vector>
+
+// -------------------------------------------
+// Key state
+// -------------------------------------------
+
+// Keys the game reads, bit i of the state is sKey[i]
+#define INPUT_NUM_KEY		10
+static const int	sKey[INPUT_NUM_KEY] = {
+	GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_J, GLFW_KEY_K, GLFW_KEY_U, GLFW_KEY_I,
+	GLFW_KEY_R, GLFW_KEY_N
+};
+
+#define INPUT_MAGIC			"GINP"
+#define INPUT_VERSION		3
+
+static int			sSource;
+static unsigned int	sState;							// Keys held in the current update
+static unsigned int	sPrevState;						// Keys held in the update before
+
+static bool			sRecord;						// Keep the state of every update in sFrame
+static std::string	sRecordFile;
+static GameInputHeader	sHeader;
+static std::vector<uint16_t>	sFrame;				// Key state of each update, recorded or replayed
+static size_t		sNextFrame;						// Replay position in sFrame
+
+
+// Fire bullets all the time, missiles and thrust on and off, turn left and right
+static unsigned int stubState(long frame)
+{
+	unsigned int state = 0;
+	state |= 1u << 4;								// J
+	if ((frame / 200) % 2)	state |= 1u << 5;		// K
+	if ((frame / 50) % 2)	state |= 1u << 2;		// A
+	else if ((frame / 25) % 2)	state |= 1u << 3;	// D
+	if ((frame / 70) % 2)	state |= 1u << 0;		// W
+	return state;
+}
+
+void GameInputInit(int source)
+{
+	sSource = source;
+	sState = 0;
+	sPrevState = 0;
+}
+
+void GameInputUpdate(long frame)
+{
+	sPrevState = sState;
+	if (sSource == INPUT_STUB) {
+		sState = stubState(frame);
+	}
+	else if (sSource == INPUT_REPLAY) {
+		sState = (sNextFrame < sFrame.size()) ? sFrame[sNextFrame++] : 0;
+	}
+	else {
+		sState = 0;
+		for (int i = 0; i < INPUT_NUM_KEY; i++) {
+			if (SystemKeyDown(sKey[i]))
+				sState |= 1u << i;
+		}
+	}
+
+	if (sRecord)
+		sFrame.push_back((uint16_t)sState);
+}
+
+bool GameInputKey(int key)
+{
+	for (int i = 0; i < INPUT_NUM_KEY; i++) {
+		if (sKey[i] == key)
+			return (sState >> i) & 1;
+	}
+	return false;
+}
+
+bool GameInputPressed(int key)
+{
+	for (int i = 0; i < INPUT_NUM_KEY; i++) {
+		if (sKey[i] == key)
+			return ((sState & ~sPrevState) >> i) & 1;
+	}
+	return false;
+}
+
+
+// -------------------------------------------
+// Record & replay
+//	- file: "GINP", version, seed, tick rate, number of asteroids, AI budget, number of updates,
+//	  then 16 bits of key state per update
+// -------------------------------------------
+
+bool GameInputRecord(const char* filename, const GameInputHeader& header)
+{
+	// fail now rather than after the session
+	FILE* pFile = fopen(filename, "wb");
+	if (pFile == NULL)
+		return false;
+	fclose(pFile);
+
+	sRecord = true;
+	sRecordFile = filename;
+	sHeader = header;
+	sFrame.clear();
+	return true;
+}
+
+bool GameInputReplay(const char* filename, GameInputHeader& header)
+{
+	FILE* pFile = fopen(filename, "rb");
+	if (pFile == NULL)
+		return false;
+
+	char			magic[4];
+	unsigned int	version = 0;
+	unsigned int	numFrame = 0;
+	bool ok = fread(magic, 4, 1, pFile) == 1 && memcmp(magic, INPUT_MAGIC, 4) == 0 &&
+		fread(&version, sizeof(version), 1, pFile) == 1 && version == INPUT_VERSION &&
+		fread(&header.seed, sizeof(header.seed), 1, pFile) == 1 &&
+		fread(&header.tickrate, sizeof(header.tickrate), 1, pFile) == 1 && header.tickrate > 0.0 &&
+		fread(&header.numAsteroid, sizeof(header.numAsteroid), 1, pFile) == 1 &&
+		fread(&header.aiBudget, sizeof(header.aiBudget), 1, pFile) == 1 &&
+		fread(&numFrame, sizeof(numFrame), 1, pFile) == 1;
+
+	if (ok) {
+		sFrame.resize(numFrame);
+		ok = numFrame == 0 || fread(sFrame.data(), sizeof(uint16_t), numFrame, pFile) == numFrame;
+	}
+	fclose(pFile);
+	if (!ok)
+		return false;
+
+	sSource = INPUT_REPLAY;
+	sState = 0;
+	sPrevState = 0;
+	sRecord = false;
+	sNextFrame = 0;
+	return true;
+}
+
+bool GameInputEnd()
+{
+	return sSource == INPUT_REPLAY && sNextFrame >= sFrame.size();
+}
+
+long GameInputNumFrame()
+{
+	return (long)sFrame.size();
+}
+
+void GameInputClose()
+{
+	if (!sRecord)
+		return;
+	sRecord = false;
+
+	FILE* pFile = fopen(sRecordFile.c_str(), "wb");
+	if (pFile == NULL) {
+		fprintf(stderr, "GameInput: cannot write %s\n", sRecordFile.c_str());
+		return;
+	}
+
+	unsigned int version = INPUT_VERSION;
+	unsigned int numFrame = (unsigned int)sFrame.size();
+	fwrite(INPUT_MAGIC, 4, 1, pFile);
+	fwrite(&version, sizeof(version), 1, pFile);
+	fwrite(&sHeader.seed, sizeof(sHeader.seed), 1, pFile);
+	fwrite(&sHeader.tickrate, sizeof(sHeader.tickrate), 1, pFile);
+	fwrite(&sHeader.numAsteroid, sizeof(sHeader.numAsteroid), 1, pFile);
+	fwrite(&sHeader.aiBudget, sizeof(sHeader.aiBudget), 1, pFile);
+	fwrite(&numFrame, sizeof(numFrame), 1, pFile);
+	if (numFrame > 0)
+		fwrite(sFrame.data(), sizeof(uint16_t), numFrame, pFile);
+	fclose(pFile);
+
+	printf("GameInput: %u updates recorded to %s\n", numFrame, sRecordFile.c_str());
+}
@@ -0,0 +1,56 @@
+#ifndef GAME_INPUT
+#define GAME_INPUT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// Include GLEW, before GLFW
+#include <GL/glew.h>
+
+// Include GLFW, for the GLFW_KEY_* codes, the keys are read through system.h
+#include <glfw3.h>
+
+// -------------------------------------------
+// Game input
+//	- the game reads its keys from here instead of glfwGetKey(), once per update
+//	- GameInputUpdate() samples the source for the next update:
+//		INPUT_LIVE		the keyboard of the window
+//		INPUT_STUB		a fixed pattern (fire, turn, thrust), no window needed, for the headless runs
+//		INPUT_REPLAY	the updates of a file written by GameInputRecord()
+//	- a recording is the key state of every update, after a header with what else the run needs
+//	  to be the same (seed, tick rate, number of asteroids, AI budget), the updates use a fixed dt so the
+//	  replayed session is the same as the recorded one
+//	- R (restart) and N (level change) are keys of the update too, main reads them with
+//	  GameInputPressed() after each update, so they are recorded and replayed with the others
+// -------------------------------------------
+
+enum INPUT_SOURCE
+{
+	INPUT_LIVE = 0,
+	INPUT_STUB,
+	INPUT_REPLAY
+};
+
+struct GameInputHeader
+{
+	uint64_t	seed;
+	double		tickrate;
+	int			numAsteroid;
+	int			aiBudget;				// AISchedulerSetBudget(), it decides which missiles steer in an update
+};
+
+void GameInputInit(int source);
+void GameInputUpdate(long frame);		// Call before each GameStateUpdate()
+bool GameInputKey(int key);				// GLFW_KEY_W/S/A/D/J/K/U/I/R/N, true when held in this update
+bool GameInputPressed(int key);			// Held in this update and not in the one before
+
+// Record/replay, return false when the file cannot be opened or is not a recording
+bool GameInputRecord(const char* filename, const GameInputHeader& header);		// Record the updates of the current source
+bool GameInputReplay(const char* filename, GameInputHeader& header);			// Switch to INPUT_REPLAY
+bool GameInputEnd();					// The replay has no update left
+long GameInputNumFrame();				// The number of updates in the replay
+void GameInputClose();					// Write the recording, call before quitting
+
+
+#endif // GAME_INPUT
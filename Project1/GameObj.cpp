@@ -0,0 +1,418 @@
+#include "GameObj.h"
+#include <new>
+#include <vector>
+
+#define CHUNK_MASK			(GAME_OBJ_CHUNK_SIZE - 1)
+#define SLOT_MASK			((1u << GAME_OBJ_SLOT_BITS) - 1)
+#define GENERATION_MAX		(0xFFFFFFFFu >> GAME_OBJ_SLOT_BITS)
+
+static_assert((GAME_OBJ_CHUNK_MAX << GAME_OBJ_CHUNK_SHIFT) <= (1 << GAME_OBJ_SLOT_BITS), "slots do not fit in a handle");
+
+// -------------------------------------------
+// Game object storage
+// -------------------------------------------
+
+// Components of the objects at index [c * GAME_OBJ_CHUNK_SIZE, (c + 1) * GAME_OBJ_CHUNK_SIZE) of a bucket
+struct GameObjChunk
+{
+	// aligned for SSE/AVX loads
+	alignas(32) glm::vec2	position[GAME_OBJ_CHUNK_SIZE];
+	alignas(32) glm::vec2	prevPosition[GAME_OBJ_CHUNK_SIZE];
+	alignas(32) glm::vec2	velocity[GAME_OBJ_CHUNK_SIZE];
+	alignas(32) glm::vec2	scale[GAME_OBJ_CHUNK_SIZE];
+	alignas(32) glm::vec2	direction[GAME_OBJ_CHUNK_SIZE];
+	alignas(32) GameObjHandle	handle[GAME_OBJ_CHUNK_SIZE];
+	alignas(32) GameObjHandle	target[GAME_OBJ_CHUNK_SIZE];
+	alignas(32) glm::mat4	modelMatrix[GAME_OBJ_CHUNK_SIZE];
+
+	GameObjArrays	arrays;								// Pointers to the components above
+};
+
+// Slots [c * GAME_OBJ_CHUNK_SIZE, (c + 1) * GAME_OBJ_CHUNK_SIZE)
+struct GameObjSlotChunk
+{
+	int				flag[GAME_OBJ_CHUNK_SIZE];			// 0 - inactive, 1 - active, 2 - destroyed
+	unsigned int	generation[GAME_OBJ_CHUNK_SIZE];	// Goes up each time the slot is freed, [1, GENERATION_MAX]
+	int				type[GAME_OBJ_CHUNK_SIZE];			// Which bucket the slot is in
+	int				index[GAME_OBJ_CHUNK_SIZE];			// Where the slot is in the bucket
+
+	// Entries [c * GAME_OBJ_CHUNK_SIZE, (c + 1) * GAME_OBJ_CHUNK_SIZE) of the free slot stack
+	int				freeSlot[GAME_OBJ_CHUNK_SIZE];
+};
+
+struct GameObjBucket
+{
+	GameObjChunk*	chunk[GAME_OBJ_CHUNK_MAX];
+	int				numChunk;							// The number of allocated chunks
+	int				count;								// The number of active objects, packed in [0, count)
+};
+
+static GameObjBucket		sBucket[GAME_OBJ_TYPE_MAX];
+static GameObjSlotChunk*	sSlot[GAME_OBJ_CHUNK_MAX];
+static int					sNumSlotChunk;				// The number of allocated slot chunks
+static int					sNumFreeSlot;				// The number of inactive slots on the stack, top is reused first
+static std::vector<int>		sKillQueue;					// Slots destroyed since the last flush
+
+#define SLOT_OF(slot)		sSlot[(slot) >> GAME_OBJ_CHUNK_SHIFT]
+#define CHUNK_OF(b, i)		(b).chunk[(i) >> GAME_OBJ_CHUNK_SHIFT]
+
+
+// -------------------------------------------
+// Chunk allocation
+// -------------------------------------------
+
+static void* alignedAlloc(size_t size, size_t alignment)
+{
+#ifdef _MSC_VER
+	return _aligned_malloc(size, alignment);
+#else
+	void* p = NULL;
+	if (posix_memalign(&p, alignment, size) != 0)
+		return NULL;
+	return p;
+#endif
+}
+
+static void alignedFree(void* p)
+{
+#ifdef _MSC_VER
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+static bool addChunk(GameObjBucket& bucket)
+{
+	if (bucket.numChunk == GAME_OBJ_CHUNK_MAX)
+		return false;
+
+	void* mem = alignedAlloc(sizeof(GameObjChunk), 32);
+	if (mem == NULL)
+		return false;
+
+	GameObjChunk* pChunk = new (mem) GameObjChunk;
+	pChunk->arrays.position = pChunk->position;
+	pChunk->arrays.prevPosition = pChunk->prevPosition;
+	pChunk->arrays.velocity = pChunk->velocity;
+	pChunk->arrays.scale = pChunk->scale;
+	pChunk->arrays.direction = pChunk->direction;
+	pChunk->arrays.handle = pChunk->handle;
+	pChunk->arrays.target = pChunk->target;
+	pChunk->arrays.modelMatrix = pChunk->modelMatrix;
+
+	bucket.chunk[bucket.numChunk++] = pChunk;
+	return true;
+}
+
+static void nextGeneration(GameObjSlotChunk* pSlot, int i)
+{
+	// skip 0, so GAME_OBJ_HANDLE_NONE is never a valid handle
+	if (++pSlot->generation[i] > GENERATION_MAX)
+		pSlot->generation[i] = 1;
+}
+
+static bool addSlotChunk()
+{
+	if (sNumSlotChunk == GAME_OBJ_CHUNK_MAX)
+		return false;
+
+	GameObjSlotChunk* pSlot = new (std::nothrow) GameObjSlotChunk;
+	if (pSlot == NULL)
+		return false;
+
+	int base = sNumSlotChunk << GAME_OBJ_CHUNK_SHIFT;
+	sSlot[sNumSlotChunk++] = pSlot;
+
+	// the new slots go on the free stack in reverse, so they are handed out from the lowest one upward
+	for (int i = GAME_OBJ_CHUNK_SIZE - 1; i >= 0; i--) {
+		pSlot->flag[i] = FLAG_INACTIVE;
+		pSlot->generation[i] = 1;
+
+		int top = sNumFreeSlot++;
+		SLOT_OF(top)->freeSlot[top & CHUNK_MASK] = base + i;
+	}
+
+	return true;
+}
+
+
+// -------------------------------------------
+// Create & Destroy
+// -------------------------------------------
+
+void GameObjReset()
+{
+	// push the slots in reverse, so the objects are handed out from slot 0 upward
+	//	- the chunks stay allocated for the next level
+	//	- every slot gets a new generation, the handles of the old level are all stale
+	for (int t = 0; t < GAME_OBJ_TYPE_MAX; t++) {
+		sBucket[t].count = 0;
+	}
+
+	sKillQueue.clear();
+
+	sNumFreeSlot = 0;
+	for (int i = (sNumSlotChunk << GAME_OBJ_CHUNK_SHIFT) - 1; i >= 0; i--) {
+		SLOT_OF(i)->flag[i & CHUNK_MASK] = FLAG_INACTIVE;
+		nextGeneration(SLOT_OF(i), i & CHUNK_MASK);
+
+		int top = sNumFreeSlot++;
+		SLOT_OF(top)->freeSlot[top & CHUNK_MASK] = i;
+	}
+}
+
+void GameObjShutdown()
+{
+	for (int t = 0; t < GAME_OBJ_TYPE_MAX; t++) {
+		GameObjBucket& bucket = sBucket[t];
+
+		for (int c = 0; c < bucket.numChunk; c++) {
+			bucket.chunk[c]->~GameObjChunk();
+			alignedFree(bucket.chunk[c]);
+			bucket.chunk[c] = NULL;
+		}
+		bucket.numChunk = 0;
+		bucket.count = 0;
+	}
+
+	for (int c = 0; c < sNumSlotChunk; c++) {
+		delete sSlot[c];
+		sSlot[c] = NULL;
+	}
+	sNumSlotChunk = 0;
+	sNumFreeSlot = 0;
+	sKillQueue.clear();
+}
+
+GameObjHandle GameObjCreate(int type, glm::vec2 pos, glm::vec2 vel, glm::vec2 scale, glm::vec2 dir)
+{
+	GameObjHandle handle;
+	if (GameObjCreateBatch(type, 1, &pos, &vel, scale, dir, &handle) == 0)
+		return GAME_OBJ_HANDLE_NONE;
+	return handle;
+}
+
+int GameObjCreateBatch(int type, int count, const glm::vec2* pos, const glm::vec2* vel, glm::vec2 scale, glm::vec2 dir, GameObjHandle* outHandle)
+{
+	GameObjBucket& bucket = sBucket[type];
+
+	// reserve everything up front: grow the slots and the bucket until the whole batch fits,
+	// or create as many as fit when all chunks are in use
+	while (sNumFreeSlot < count && addSlotChunk())
+		;
+	while ((bucket.numChunk << GAME_OBJ_CHUNK_SHIFT) - bucket.count < count && addChunk(bucket))
+		;
+	if (count > sNumFreeSlot)
+		count = sNumFreeSlot;
+	if (count > (bucket.numChunk << GAME_OBJ_CHUNK_SHIFT) - bucket.count)
+		count = (bucket.numChunk << GAME_OBJ_CHUNK_SHIFT) - bucket.count;
+
+	// fill the bucket one chunk at a time, the objects are appended after the last active one
+	int n = 0;
+	while (n < count) {
+		int index = bucket.count;
+		GameObjChunk* pChunk = CHUNK_OF(bucket, index);
+		int first = index & CHUNK_MASK;
+		int num = GAME_OBJ_CHUNK_SIZE - first;
+		if (num > count - n)
+			num = count - n;
+
+		for (int i = 0; i < num; i++) {
+			// pop a free slot from the stack
+			int top = --sNumFreeSlot;
+			int slot = SLOT_OF(top)->freeSlot[top & CHUNK_MASK];
+
+			GameObjSlotChunk* pSlot = SLOT_OF(slot);
+			pSlot->flag[slot & CHUNK_MASK] = FLAG_ACTIVE;
+			pSlot->type[slot & CHUNK_MASK] = type;
+			pSlot->index[slot & CHUNK_MASK] = index + i;
+
+			GameObjHandle handle = (pSlot->generation[slot & CHUNK_MASK] << GAME_OBJ_SLOT_BITS) | slot;
+			if (outHandle != NULL)
+				outHandle[n + i] = handle;
+
+			int j = first + i;
+			pChunk->position[j] = pos[n + i];
+			pChunk->prevPosition[j] = pos[n + i];
+			pChunk->velocity[j] = vel[n + i];
+			pChunk->scale[j] = scale;
+			pChunk->direction[j] = dir;
+			pChunk->handle[j] = handle;
+			pChunk->target[j] = GAME_OBJ_HANDLE_NONE;
+			pChunk->modelMatrix[j] = GameObjModelMatrix(pos[n + i], scale, dir);	// drawn as is until its first update
+		}
+
+		bucket.count += num;
+		n += num;
+	}
+
+	return count;
+}
+
+void GameObjDestroy(GameObjHandle handle)
+{
+	// Lazy deletion, only mark it and remember it for the flush
+	if (GameObjFlag(handle) != FLAG_ACTIVE)
+		return;
+
+	int slot = handle & SLOT_MASK;
+	SLOT_OF(slot)->flag[slot & CHUNK_MASK] = FLAG_DESTROYED;
+	sKillQueue.push_back(slot);
+}
+
+static void removeObj(int slot)
+{
+	GameObjSlotChunk* pSlot = SLOT_OF(slot);
+	pSlot->flag[slot & CHUNK_MASK] = FLAG_INACTIVE;
+	nextGeneration(pSlot, slot & CHUNK_MASK);
+
+	// move the last object of the bucket into the hole (swap-and-pop)
+	GameObjBucket& bucket = sBucket[pSlot->type[slot & CHUNK_MASK]];
+	int index = pSlot->index[slot & CHUNK_MASK];
+	int last = --bucket.count;
+	if (index != last) {
+		GameObjChunk* pDst = CHUNK_OF(bucket, index);
+		GameObjChunk* pSrc = CHUNK_OF(bucket, last);
+		int i = index & CHUNK_MASK;
+		int j = last & CHUNK_MASK;
+
+		pDst->position[i] = pSrc->position[j];
+		pDst->prevPosition[i] = pSrc->prevPosition[j];
+		pDst->velocity[i] = pSrc->velocity[j];
+		pDst->scale[i] = pSrc->scale[j];
+		pDst->direction[i] = pSrc->direction[j];
+		pDst->handle[i] = pSrc->handle[j];
+		pDst->target[i] = pSrc->target[j];
+		pDst->modelMatrix[i] = pSrc->modelMatrix[j];
+
+		int moved = pDst->handle[i] & SLOT_MASK;
+		SLOT_OF(moved)->index[moved & CHUNK_MASK] = index;
+	}
+
+	// give the slot back to the free stack
+	int top = sNumFreeSlot++;
+	SLOT_OF(top)->freeSlot[top & CHUNK_MASK] = slot;
+}
+
+void GameObjFlush(bool compact)
+{
+	for (size_t k = 0; k < sKillQueue.size(); k++) {
+		removeObj(sKillQueue[k]);
+	}
+	sKillQueue.clear();
+
+	if (!compact)
+		return;
+
+	// keep one spare chunk after the last used one, so a bucket going up and down
+	// around a chunk boundary does not allocate every frame
+	for (int t = 0; t < GAME_OBJ_TYPE_MAX; t++) {
+		GameObjBucket& bucket = sBucket[t];
+		int keep = GameObjNumChunk(t) + 1;
+
+		while (bucket.numChunk > keep) {
+			GameObjChunk* pChunk = bucket.chunk[--bucket.numChunk];
+			pChunk->~GameObjChunk();
+			alignedFree(pChunk);
+			bucket.chunk[bucket.numChunk] = NULL;
+		}
+	}
+}
+
+
+// -------------------------------------------
+// Accessors
+// -------------------------------------------
+
+int GameObjCount(int type)
+{
+	return sBucket[type].count;
+}
+
+bool GameObjIsValid(GameObjHandle handle)
+{
+	return GameObjFlag(handle) == FLAG_ACTIVE;
+}
+
+int GameObjFlag(GameObjHandle handle)
+{
+	int slot = handle & SLOT_MASK;
+	if (slot >= (sNumSlotChunk << GAME_OBJ_CHUNK_SHIFT))
+		return FLAG_INACTIVE;
+
+	// a stale handle is inactive, whatever is in the slot now
+	GameObjSlotChunk* pSlot = SLOT_OF(slot);
+	if (pSlot->generation[slot & CHUNK_MASK] != (handle >> GAME_OBJ_SLOT_BITS))
+		return FLAG_INACTIVE;
+
+	return pSlot->flag[slot & CHUNK_MASK];
+}
+
+int GameObjType(GameObjHandle handle)
+{
+	int slot = handle & SLOT_MASK;
+	return SLOT_OF(slot)->type[slot & CHUNK_MASK];
+}
+
+int GameObjNumChunk(int type)
+{
+	return (sBucket[type].count + CHUNK_MASK) >> GAME_OBJ_CHUNK_SHIFT;
+}
+
+int GameObjChunkCount(int type, int chunk)
+{
+	int count = sBucket[type].count - (chunk << GAME_OBJ_CHUNK_SHIFT);
+	if (count > GAME_OBJ_CHUNK_SIZE)
+		return GAME_OBJ_CHUNK_SIZE;
+	return count > 0 ? count : 0;
+}
+
+const GameObjArrays& GameObjChunkData(int type, int chunk)
+{
+	return sBucket[type].chunk[chunk]->arrays;
+}
+
+const GameObjArrays& GameObjFind(GameObjHandle handle, int& index)
+{
+	int slot = handle & SLOT_MASK;
+	GameObjSlotChunk* pSlot = SLOT_OF(slot);
+	GameObjBucket& bucket = sBucket[pSlot->type[slot & CHUNK_MASK]];
+
+	int i = pSlot->index[slot & CHUNK_MASK];
+	index = i & CHUNK_MASK;
+	return CHUNK_OF(bucket, i)->arrays;
+}
+
+void GameObjReport(bool perChunk)
+{
+	size_t bytes = sizeof(GameObjChunk);
+	size_t slotBytes = sizeof(GameObjSlotChunk);
+	size_t total = sNumSlotChunk * slotBytes;
+
+	for (int t = 0; t < GAME_OBJ_TYPE_MAX; t++) {
+		total += sBucket[t].numChunk * bytes;
+	}
+
+	printf("GameObj: chunks of %d, %.1f KB per object chunk, %.1f KB per slot chunk, %.1f MB total\n",
+		GAME_OBJ_CHUNK_SIZE, bytes / 1024.0, slotBytes / 1024.0, total / (1024.0 * 1024.0));
+	printf("  slots: %d in use, %d chunks\n", (sNumSlotChunk << GAME_OBJ_CHUNK_SHIFT) - sNumFreeSlot, sNumSlotChunk);
+
+	for (int t = 0; t < GAME_OBJ_TYPE_MAX; t++) {
+		GameObjBucket& bucket = sBucket[t];
+		if (bucket.numChunk == 0)
+			continue;
+
+		printf("  type %d: %d objects, %d chunks, %.1f MB\n", t, bucket.count, bucket.numChunk,
+			bucket.numChunk * bytes / (1024.0 * 1024.0));
+
+		if (!perChunk)
+			continue;
+
+		for (int c = 0; c < bucket.numChunk; c++) {
+			int count = GameObjChunkCount(t, c);
+			printf("    chunk %3d: %4d/%d active, %.1f KB, %.1f bytes per active object\n",
+				c, count, GAME_OBJ_CHUNK_SIZE, bytes / 1024.0, count > 0 ? (double)bytes / count : 0.0);
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#ifndef GAME_OBJ
+#define GAME_OBJ
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#define GAME_OBJ_TYPE_MAX			8								// The total number of buckets, the types must be in [0, 8)
+#define GAME_OBJ_CHUNK_SHIFT		12
+#define GAME_OBJ_CHUNK_SIZE			(1 << GAME_OBJ_CHUNK_SHIFT)		// The number of game object instances per chunk
+#define GAME_OBJ_CHUNK_MAX			256								// The total number of chunks per bucket and of slot chunks, 256 * 4096 = 1M instances
+
+#define GAME_OBJ_SLOT_BITS			20								// Handle = generation << 20 | slot, 2^20 = 1M slots
+#define GAME_OBJ_HANDLE_NONE		0								// Never handed out, the generations start at 1
+
+#define FLAG_INACTIVE		0
+#define FLAG_ACTIVE			1
+#define FLAG_DESTROYED		2				// still in the arrays until the next GameObjFlush()
+
+// -------------------------------------------
+// Game object storage, structure of arrays
+//	- an object is named by a 32-bit handle: the slot it got plus the generation of that slot,
+//	  the generation changes when the slot is freed, so a handle to a dead object never
+//	  matches a newer object in the same slot
+//	- each type has its own bucket, a system only walks the types it cares about
+//	- the components of the active objects of a bucket are packed at the front, chunk after chunk,
+//	  the order changes when an object is destroyed (the last one is moved into the hole)
+//	- hot components (position, velocity, ...) and the cold modelMatrix live in separate arrays,
+//	  so the integration/collision passes only stream what they use
+//	- the storage grows one chunk at a time, a chunk never moves once it is allocated
+//	- destroy only queues the object, GameObjFlush() removes the queued objects once per frame,
+//	  so the arrays do not change under a pass that destroys objects
+// -------------------------------------------
+
+typedef unsigned int GameObjHandle;
+
+struct GameObjArrays
+{
+	glm::vec2*		position;			// usually we will use only x and y
+	glm::vec2*		prevPosition;		// position before the last simulation step, for the render interpolation
+	glm::vec2*		velocity;
+	glm::vec2*		scale;
+	glm::vec2*		direction;			// unit vector the object faces, the +y axis of the mesh, (0, 1) is 12 o'clock
+	GameObjHandle*	handle;				// handle of the object stored at this index
+	GameObjHandle*	target;				// object this one goes after (missiles), GAME_OBJ_HANDLE_NONE = none, may be stale
+	glm::mat4*		modelMatrix;
+};
+
+// -------------------------------------------
+// Create & Destroy
+// -------------------------------------------
+
+void GameObjReset();
+void GameObjShutdown();				// Reset and give the chunks back to the system
+GameObjHandle GameObjCreate(int type, glm::vec2 pos, glm::vec2 vel, glm::vec2 scale, glm::vec2 dir);	// return GAME_OBJ_HANDLE_NONE when full
+int GameObjCreateBatch(int type, int count, const glm::vec2* pos, const glm::vec2* vel,
+	glm::vec2 scale, glm::vec2 dir, GameObjHandle* outHandle);	// Create count objects in one pass, outHandle may be NULL, return the number created
+void GameObjDestroy(GameObjHandle handle);		// Queue the object to be removed by the next GameObjFlush()
+void GameObjFlush(bool compact);	// Remove the queued objects, compact = also free the unused chunks at the back of the buckets
+
+// -------------------------------------------
+// Accessors
+//	- walk the objects of a type chunk by chunk:
+//		for (int c = 0; c < GameObjNumChunk(type); c++)
+//			for (int i = 0; i < GameObjChunkCount(type, c); i++)
+//				GameObjChunkData(type, c).position[i] ...
+// -------------------------------------------
+
+int  GameObjCount(int type);						// Include the destroyed objects that are not flushed yet
+bool GameObjIsValid(GameObjHandle handle);			// Same as GameObjFlag(handle) == FLAG_ACTIVE, O(1)
+int  GameObjFlag(GameObjHandle handle);				// FLAG_ACTIVE, FLAG_DESTROYED or FLAG_INACTIVE (also for a stale handle)
+int  GameObjType(GameObjHandle handle);
+int  GameObjNumChunk(int type);						// The number of chunks holding active objects of the type
+int  GameObjChunkCount(int type, int chunk);		// The number of active objects in the chunk
+const GameObjArrays& GameObjChunkData(int type, int chunk);
+const GameObjArrays& GameObjFind(GameObjHandle handle, int& index);	// Arrays holding a valid object and its index in them, valid until the next flush
+
+// Print the memory used by the chunks
+void GameObjReport(bool perChunk);
+
+// tMat * sMat * rMat written out, rotate around z axis then scale then translate
+//	- the rotation takes +y to dir, so cos = dir.y and sin = -dir.x, no trig
+//	- inline, the update passes build one per object
+inline glm::mat4 GameObjModelMatrix(const glm::vec2& pos, const glm::vec2& scale, const glm::vec2& dir)
+{
+	float c = dir.y;
+	float s = -dir.x;
+
+	glm::mat4 modelMatrix(1.0f);
+	modelMatrix[0] = glm::vec4(scale.x * c, scale.y * s, 0.0f, 0.0f);
+	modelMatrix[1] = glm::vec4(-scale.x * s, scale.y * c, 0.0f, 0.0f);
+	modelMatrix[3] = glm::vec4(pos, 0.0f, 1.0f);
+	return modelMatrix;
+}
+
+
+#endif // GAME_OBJ
@@ -0,0 +1,181 @@
+#include "GameObjKernel.h"
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define KERNEL_TARGET_SSE2
+#define KERNEL_TARGET_AVX
+#else
+#define KERNEL_TARGET_SSE2		__attribute__((target("sse2")))
+#define KERNEL_TARGET_AVX		__attribute__((target("avx")))
+#endif
+#endif
+
+enum KERNEL_LEVEL
+{
+	KERNEL_SCALAR = 0,
+	KERNEL_SSE2,
+	KERNEL_AVX,
+
+	NUM_KERNEL
+};
+static const char*	sKernelName[NUM_KERNEL] = { "scalar", "SSE2", "AVX" };
+
+
+// -------------------------------------------
+// Scalar
+// -------------------------------------------
+
+void GameObjIntegrateScalar(const GameObjArrays& obj, int first, int count, float dt, int halfWidth, int halfHeight, bool wrap)
+{
+	// (int)abs(x) > half  <=>  abs(x) >= half + 1
+	float edgeX = (float)(halfWidth + 1);
+	float edgeY = (float)(halfHeight + 1);
+
+	for (int i = first; i < first + count; i++) {
+		obj.prevPosition[i] = obj.position[i];
+		obj.position[i] += obj.velocity[i] * dt;
+
+		if (!wrap)
+			continue;
+
+		if (fabsf(obj.position[i].x) >= edgeX) {
+			obj.position[i].x *= -1;
+			obj.prevPosition[i].x = obj.position[i].x;
+		}
+		if (fabsf(obj.position[i].y) >= edgeY) {
+			obj.position[i].y *= -1;
+			obj.prevPosition[i].y = obj.position[i].y;
+		}
+	}
+}
+
+
+// -------------------------------------------
+// SIMD
+//	- wrap without branches: mask = abs(p) >= edge, p ^= mask & sign bit, prev = mask ? p : prev
+//	- the objects that do not fill a register go through the scalar version
+// -------------------------------------------
+
+#if defined(KERNEL_X86)
+
+KERNEL_TARGET_AVX
+static void integrateAVX(const GameObjArrays& obj, int first, int count, float dt, int halfWidth, int halfHeight, bool wrap)
+{
+	float* pos = (float*)(obj.position + first);
+	float* prev = (float*)(obj.prevPosition + first);
+	const float* vel = (const float*)(obj.velocity + first);
+
+	__m256 vDt = _mm256_set1_ps(dt);
+	__m256 vSign = _mm256_set1_ps(-0.0f);
+	__m256 vEdge = _mm256_setr_ps((float)(halfWidth + 1), (float)(halfHeight + 1), (float)(halfWidth + 1), (float)(halfHeight + 1),
+		(float)(halfWidth + 1), (float)(halfHeight + 1), (float)(halfWidth + 1), (float)(halfHeight + 1));
+
+	// 4 objects (8 floats) per step
+	int n = count & ~3;
+	for (int i = 0; i < n * 2; i += 8) {
+		__m256 p = _mm256_loadu_ps(pos + i);
+		__m256 old = p;
+
+		p = _mm256_add_ps(p, _mm256_mul_ps(_mm256_loadu_ps(vel + i), vDt));
+
+		if (wrap) {
+			__m256 mask = _mm256_cmp_ps(_mm256_andnot_ps(vSign, p), vEdge, _CMP_GE_OQ);
+			p = _mm256_xor_ps(p, _mm256_and_ps(mask, vSign));
+			old = _mm256_blendv_ps(old, p, mask);
+		}
+		_mm256_storeu_ps(prev + i, old);
+		_mm256_storeu_ps(pos + i, p);
+	}
+
+	GameObjIntegrateScalar(obj, first + n, count - n, dt, halfWidth, halfHeight, wrap);
+}
+
+KERNEL_TARGET_SSE2
+static void integrateSSE2(const GameObjArrays& obj, int first, int count, float dt, int halfWidth, int halfHeight, bool wrap)
+{
+	float* pos = (float*)(obj.position + first);
+	float* prev = (float*)(obj.prevPosition + first);
+	const float* vel = (const float*)(obj.velocity + first);
+
+	__m128 vDt = _mm_set1_ps(dt);
+	__m128 vSign = _mm_set1_ps(-0.0f);
+	__m128 vEdge = _mm_setr_ps((float)(halfWidth + 1), (float)(halfHeight + 1), (float)(halfWidth + 1), (float)(halfHeight + 1));
+
+	// 2 objects (4 floats) per step
+	int n = count & ~1;
+	for (int i = 0; i < n * 2; i += 4) {
+		__m128 p = _mm_loadu_ps(pos + i);
+		__m128 old = p;
+
+		p = _mm_add_ps(p, _mm_mul_ps(_mm_loadu_ps(vel + i), vDt));
+
+		if (wrap) {
+			__m128 mask = _mm_cmpge_ps(_mm_andnot_ps(vSign, p), vEdge);
+			p = _mm_xor_ps(p, _mm_and_ps(mask, vSign));
+			old = _mm_or_ps(_mm_and_ps(mask, p), _mm_andnot_ps(mask, old));
+		}
+		_mm_storeu_ps(prev + i, old);
+		_mm_storeu_ps(pos + i, p);
+	}
+
+	GameObjIntegrateScalar(obj, first + n, count - n, dt, halfWidth, halfHeight, wrap);
+}
+
+// Best level of the CPU, the OS must also save the AVX registers (XCR0)
+static int detectLevel()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+		return KERNEL_AVX;
+	return sse2 ? KERNEL_SSE2 : KERNEL_SCALAR;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx"))
+		return KERNEL_AVX;
+	if (__builtin_cpu_supports("sse2"))
+		return KERNEL_SSE2;
+	return KERNEL_SCALAR;
+#endif
+}
+
+#else
+
+static int detectLevel()
+{
+	return KERNEL_SCALAR;
+}
+
+#endif
+
+
+// -------------------------------------------
+// Dispatch
+// -------------------------------------------
+
+static int sLevel = detectLevel();
+
+void GameObjIntegrate(const GameObjArrays& obj, int first, int count, float dt, int halfWidth, int halfHeight, bool wrap)
+{
+#if defined(KERNEL_X86)
+	if (sLevel == KERNEL_AVX)
+		integrateAVX(obj, first, count, dt, halfWidth, halfHeight, wrap);
+	else if (sLevel == KERNEL_SSE2)
+		integrateSSE2(obj, first, count, dt, halfWidth, halfHeight, wrap);
+	else
+#endif
+		GameObjIntegrateScalar(obj, first, count, dt, halfWidth, halfHeight, wrap);
+}
+
+const char* GameObjKernelName()
+{
+	return sKernelName[sLevel];
+}
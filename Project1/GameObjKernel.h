@@ -0,0 +1,26 @@
+#ifndef GAME_OBJ_KERNEL
+#define GAME_OBJ_KERNEL
+
+#include "GameObj.h"
+
+// -------------------------------------------
+// Update kernels over the component arrays of a chunk
+//	- the SIMD version is picked at run time from cpuid: AVX 4 objects per instruction, SSE2 2 objects
+//	  per instruction, scalar otherwise; each is compiled for its instruction set, the project needs
+//	  no /arch or -m flag, same as CollisionKernel
+//	- position/velocity are interleaved x, y, so a register holds whole objects
+//	- the scalar version is always built, it is the reference for the benchmark
+// -------------------------------------------
+
+// Objects [first, first + count) of obj:
+//	- prevPosition = position, position += velocity * dt
+//	- wrap = true: a coordinate past the screen edge (+-half, same as (int)abs(x) > half) flips its sign,
+//	  prevPosition follows it so the object is not interpolated across the screen
+void GameObjIntegrate(const GameObjArrays& obj, int first, int count, float dt, int halfWidth, int halfHeight, bool wrap);
+void GameObjIntegrateScalar(const GameObjArrays& obj, int first, int count, float dt, int halfWidth, int halfHeight, bool wrap);
+
+// "AVX", "SSE2" or "scalar"
+const char* GameObjKernelName();
+
+
+#endif // GAME_OBJ_KERNEL
@@ -0,0 +1,14 @@
+#include "GameRandom.h"
+#include <time.h>
+
+static uint64_t	sSeed = (uint64_t)time(NULL);
+
+void GameRandomSetSeed(uint64_t seed)
+{
+	sSeed = seed;
+}
+
+uint64_t GameRandomGetSeed()
+{
+	return sSeed;
+}
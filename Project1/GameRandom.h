@@ -0,0 +1,62 @@
+#ifndef GAME_RANDOM
+#define GAME_RANDOM
+
+#include <stdint.h>
+
+// -------------------------------------------
+// Random numbers, PCG32 (permuted congruential generator, pcg-random.org)
+//	- each level has its own generator, seeded from GameRandomGetSeed() in Init,
+//	  so the same seed (--seed) gives the same asteroid field
+//	- not thread safe, one generator per thread
+//	- inline, they are called in the spawn loops
+// -------------------------------------------
+
+struct GameRandom
+{
+	uint64_t	state;
+	uint64_t	inc;				// Stream, always odd
+};
+
+// The seed of the run, from --seed or the time at startup
+void     GameRandomSetSeed(uint64_t seed);
+uint64_t GameRandomGetSeed();
+
+inline unsigned int GameRandomNext(GameRandom& rng)
+{
+	uint64_t old = rng.state;
+	rng.state = old * 6364136223846793005ULL + rng.inc;
+
+	unsigned int xorshifted = (unsigned int)(((old >> 18u) ^ old) >> 27u);
+	unsigned int rot = (unsigned int)(old >> 59u);
+	return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31));
+}
+
+inline void GameRandomSeed(GameRandom& rng, uint64_t seed, uint64_t stream = 0)
+{
+	rng.state = 0;
+	rng.inc = (stream << 1u) | 1u;
+	GameRandomNext(rng);
+	rng.state += seed;
+	GameRandomNext(rng);
+}
+
+// [0, n), n > 0
+inline int GameRandomInt(GameRandom& rng, int n)
+{
+	return (int)(((uint64_t)GameRandomNext(rng) * (unsigned int)n) >> 32);
+}
+
+// [0, 1)
+inline float GameRandomFloat(GameRandom& rng)
+{
+	return (GameRandomNext(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+// [min, max)
+inline float GameRandomRange(GameRandom& rng, float min, float max)
+{
+	return min + (max - min) * GameRandomFloat(rng);
+}
+
+
+#endif // GAME_RANDOM
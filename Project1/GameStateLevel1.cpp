@@ -1,7 +1,25 @@
 
 #include "GameStateLevel1.h"
+#include "AabbTree.h"
+#include "AIScheduler.h"
 #include "CDT.h"
+#include "CollisionKernel.h"
+#include "GameObj.h"
+#include "GameInput.h"
+#include "GameObjKernel.h"
+#include "GameRandom.h"
+#include "JobSystem.h"
+#include "SpatialGrid.h"
+#include "SweepPrune.h"
+#include "system.h"
+#include "TaskGraph.h"
 #include <cstdlib>
+#include <float.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <glm/gtx/fast_trigonometry.hpp>
 
 
 // -------------------------------------------
@@ -10,16 +28,29 @@
 
 #define MESH_MAX					32				// The total number of Mesh (Shape)
 #define TEXTURE_MAX					32				// The total number of texture
-#define GAME_OBJ_INST_MAX			1024			// The total number of different game object instances
 #define PLAYER_INITIAL_NUM			3				// initial number of ship lives
 #define NUM_ASTEROID				33
 #define SHIP_ACC_FWD				150.0f			// ship forward acceleration (in m/s^2)
 #define SHIP_ACC_BWD				-180.0f			// ship backward acceleration (in m/s^2)
 #define SHIP_ROT_SPEED				(2.0f * PI)		// ship rotation speed (degree/second)
 #define HOMING_MISSILE_ROT_SPEED	(PI / 2.0f)		// homing missile rotation speed (degree/second)
+#define HOMING_MISSILE_COS_CONE		0.5f			// cos of the half angle of the cone a missile looks for a target in, 60 degrees
+#define HOMING_MISSILE_COS_LOCK		0.0f			// cos of the half angle of the cone a missile keeps its target in, 90 degrees
+#define HOMING_MISSILE_RETARGET		4				// A missile with no target looks for one every 4 updates, power of 2
+#define HOMING_MISSILE_NUM_HIT		4				// Candidates per search, the grid may hold asteroids destroyed since it was built
 #define BULLET_SPEED				300.0f			
 #define ASTEROID_SPEED				100.0f	
+#define BROADPHASE_GRID_MIN			80				// Asteroids from which the grid broadphase is faster than the loop, unless --broadphase
+#define ASTEROID_TREE_MARGIN		16.0f			// Fat box margin of the asteroids in the Box2D tree, several updates of ASTEROID_SPEED
 #define MAX_SHIP_VELOCITY			200.0f
+#define SHIP_FRICTION				0.995f			// ship velocity kept per 1/60 s
+#define BULLET_FIRE_INTERVAL		(8.0f / 60.0f)	// seconds between two bullets while J is held
+#define MISSILE_FIRE_INTERVAL		(10.0f / 60.0f)	// seconds between two missiles while K is held
+#define SHOW_ITERATION_COUNT		0				// 1 = print how many objects the update passes visit
+#define UPDATE_BLOCK				256				// Objects integrated at once by updatePass(), 256 * 24 bytes stay in L1
+#define PARALLEL_GRAIN				16				// Blocks per job, 16 * 256 = one chunk
+
+static_assert(GAME_OBJ_CHUNK_SIZE % UPDATE_BLOCK == 0, "a block must not cross a chunk");
 
 enum GAMEOBJ_TYPE
 {
@@ -28,31 +59,90 @@ enum GAMEOBJ_TYPE
 	TYPE_BULLET,
 	TYPE_ASTEROID,
 	TYPE_BACKGROUND,
-	TYPE_MISSILE
+	TYPE_MISSILE,
+
+	NUM_TYPE
 };
 
-#define FLAG_INACTIVE		0
-#define FLAG_ACTIVE			1
+// What happens to an object of the type leaving the screen
+enum EDGE_MODE
+{
+	EDGE_NONE = 0,
+	EDGE_WRAP,				// comes back on the other side
+	EDGE_KILL				// is destroyed
+};
+static const int	sEdgeMode[NUM_TYPE] = { EDGE_WRAP, EDGE_KILL, EDGE_WRAP, EDGE_NONE, EDGE_KILL };
+
+// Collision shape of each type, in the frame of the object: +y = direction, sizes are fractions of the scale
+//	- the meshes are unit quads, 0.5 reaches the edge of the sprite
+//	- an asteroid is a circle, the targets are tested against it with a squared distance
+//	- the broadphase boxes are position +- scale of the asteroid: the radius of an asteroid plus the
+//	  reach of a target (halfLength + radius) must stay within the scale of the asteroid
+enum SHAPE_KIND
+{
+	SHAPE_NONE = 0,
+	SHAPE_POINT,
+	SHAPE_SEGMENT,		// from -halfLength to +halfLength along the direction
+	SHAPE_CIRCLE,
+	SHAPE_CAPSULE		// segment + radius
+};
 
+struct CollisionShape
+{
+	int			kind;
+	float		radius;			// of scale.x
+	float		halfLength;		// of scale.y
+};
 
-// -------------------------------------------
-// Structure definitions
-// -------------------------------------------
+static const CollisionShape	sShape[NUM_TYPE] = {
+	{ SHAPE_CAPSULE, 0.2f, 0.25f },		// TYPE_SHIP, nose to tail
+	{ SHAPE_POINT, 0.0f, 0.0f },		// TYPE_BULLET
+	{ SHAPE_CIRCLE, 0.5f, 0.0f },		// TYPE_ASTEROID
+	{ SHAPE_NONE, 0.0f, 0.0f },			// TYPE_BACKGROUND
+	{ SHAPE_SEGMENT, 0.0f, 0.4f }		// TYPE_MISSILE
+};
+
+// Buckets an asteroid can collide with
+#define NUM_TARGET_TYPE		3
+static const int	sTargetType[NUM_TARGET_TYPE] = { TYPE_SHIP, TYPE_BULLET, TYPE_MISSILE };
+
+// How the broadphase finds the pairs, --broadphase
+enum BROADPHASE_MODE
+{
+	BROADPHASE_LOOP = 0,	// every asteroid against every target, O(n * m)
+	BROADPHASE_GRID,		// the asteroids in a uniform grid rebuilt every update, each target reads the cells around it
+	BROADPHASE_SAP,			// sweep and prune along x, the order sorted in the last update is sorted again
+	BROADPHASE_TREE,		// the asteroids in a Box2D dynamic tree with fat boxes, kept from one update to the next
+
+	NUM_BROADPHASE
+};
+static const char*	sBroadphaseName[NUM_BROADPHASE] = { "loop", "grid", "sap", "tree" };
+
+// Buckets in the order they are drawn, the background must come first
+static const int	sDrawOrder[NUM_TYPE] = { TYPE_BACKGROUND, TYPE_SHIP, TYPE_ASTEROID, TYPE_BULLET, TYPE_MISSILE };
 
-struct GameObj
+// What the update/draw phases read and write, see TaskGraphAdd()
+//	- a bucket is one resource: its objects, their components and their slots
+//	- the phases of different buckets run at the same time, see GameStateLevel1Load()
+enum LEVEL1_RESOURCE
 {
-	CDTMesh* mesh;
-	CDTTex* tex;
-	int				type;				// enum GAMEOBJ_TYPE
-	int				flag;				// 0 - inactive, 1 - active
-	glm::vec3		position;			// usually we will use only x and y
-	glm::vec3		velocity;			// usually we will use only x and y
-	glm::vec3		scale;				// usually we will use only x and y
-	float			orientation;		// 0 radians is 3 o'clock, PI/2 radian is 12 o'clock
-	glm::mat4		modelMatrix;
+	RES_INPUT		= 1 << 0,		// keyboard, camera
+	RES_SHIP		= 1 << 1,
+	RES_BULLET		= 1 << 2,
+	RES_ASTEROID	= 1 << 3,
+	RES_MISSILE		= 1 << 4,		// also the targets of the missiles
+	RES_BACKGROUND	= 1 << 5,
+	RES_TARGET		= 1 << 6,		// the asteroid grid the missiles look for a target in
+	RES_PAIRS		= 1 << 7,		// the pairs found and tested by the broadphase
+	RES_DESTROY		= 1 << 8,		// the destroy queue, the lives and the restart state
+	RES_DRAW_LIST	= 1 << 9,
+	RES_SCREEN		= 1 << 10,		// GL
+
+	RES_OBJECTS		= RES_SHIP | RES_BULLET | RES_ASTEROID | RES_MISSILE | RES_BACKGROUND
 };
 
 
+
 // -------------------------------------------
 // Level variable, static - visible only in this file
 // -------------------------------------------
@@ -61,77 +151,79 @@ static CDTMesh		sMeshArray[MESH_MAX];							// Store all unique shape/mesh in yo
 static int			sNumMesh;
 static CDTTex		sTexArray[TEXTURE_MAX];							// Corresponding texture of the mesh
 static int			sNumTex;
-static GameObj		sGameObjInstArray[GAME_OBJ_INST_MAX];			// Store all game object instance
-static int			sNumGameObj;
+static std::atomic<long>	sNumIteration;							// Number of objects visited by the passes in this frame
 
-static GameObj* sPlayer;										// Pointer to the Player game object instance
-static GameObj* sBackground;									// Pointer to the Background game object instance
+// game object instances are stored in GameObj.cpp, see GameObjCreate()/GameObjDestroy()
+static GameObjHandle	sPlayer;									// Handle of the Player game object instance
+static GameObjHandle	sBackground;								// Handle of the Background game object instance
+static SpatialGrid*	sAsteroidGrid;								// The asteroids, rebuilt every HOMING_MISSILE_RETARGET updates for the missile targets
 
 static int			sPlayerLives;									// The number of lives left
 static int			sScore;
+static float		sBulletCooldown;								// Seconds until the next bullet/missile can be fired
+static float		sMissileCooldown;
+static int			sNumAsteroid = NUM_ASTEROID;					// Asteroids created by Init, --asteroids for stress runs
+static GameRandom	sRandom;										// Seeded by Init with GameRandomGetSeed()
 
-
-// functions to create/destroy a game object instance
-static GameObj* gameObjInstCreate(int type, glm::vec3 pos, glm::vec3 vel, glm::vec3 scale, float orient);
-static void			gameObjInstDestroy(GameObj& pInst);
+// Asteroid against ship/bullet/missile, found and tested by the broadphase, applied by the narrowphase
+struct CollisionPair
+{
+	GameObjHandle	obj1;											// the asteroid
+	GameObjHandle	obj2;
+	int				type2;
+	bool			hit;											// The shapes touch, see checkCollision()
+};
+static std::vector<CollisionPair>	sPairs;
+static int			sBroadphase = BROADPHASE_LOOP;
+static int			sBroadphaseArg = -1;									// --broadphase, -1 = from the asteroid count, see BROADPHASE_GRID_MIN
+static SpatialGrid*	sCollisionGrid;									// The asteroids, for BROADPHASE_GRID
+static SweepPrune*	sSweepPrune;									// The asteroids and the targets, for BROADPHASE_SAP
+static AabbTree*	sCollisionTree;									// The asteroids, for BROADPHASE_TREE
+
+// A pair with the bucket index of its objects, to put the pairs back in the order of broadphaseLoop()
+struct IndexedPair
+{
+	int				asteroid;
+	int				target;											// Index among all the targets, sTargetType order
+	CollisionPair	pair;
+};
+static std::vector<std::vector<IndexedPair> >	sBlockPairs;		// Pairs found by each block of targets
+static std::vector<IndexedPair>	sIndexedPairs;
+static std::vector<IndexedPair>	sSortedPairs;
+static std::vector<int>			sPairStart;							// Counting sort of sIndexedPairs
+static std::vector<SweepPrunePair>	sSweepPairs;
+
+// Update() and Draw() run as task graphs, built by Load()
+static TaskGraph*	sUpdateGraph;
+static TaskGraph*	sDrawGraph;
+static float		sTickDt;										// Update() arguments, for the nodes
+static long			sTickFrame;
+static int			sTickState;
+static float		sDrawAlpha;										// Draw() argument, for the nodes
+static std::vector<glm::mat4>	sDrawList;							// Interpolated modelMatrix of every object, in draw order
+static int			sDrawFirst[NUM_TYPE + 1];						// [sDrawFirst[k], sDrawFirst[k + 1]) are of type sDrawOrder[k]
 
 
 // -------------------------------------------
 // Game object instant functions
 // -------------------------------------------
 
-GameObj* gameObjInstCreate(int type, glm::vec3 pos, glm::vec3 vel, glm::vec3 scale, float orient)
-{
-	// loop through all object instance array to find the free slot
-	for (int i = 0; i < GAME_OBJ_INST_MAX; i++) {
-		GameObj* pInst = sGameObjInstArray + i;
-
-		if (pInst->flag == FLAG_INACTIVE) {
-
-			pInst->mesh = sMeshArray + type;
-			pInst->tex = sTexArray + type;
-			pInst->type = type;
-			pInst->flag = FLAG_ACTIVE;
-			pInst->position = pos;
-			pInst->velocity = vel;
-			pInst->scale = scale;
-			pInst->orientation = orient;
-			pInst->modelMatrix = glm::mat4(1.0f);
-
-			sNumGameObj++;
-			return pInst;
-		}
-	}
-
-	// Cannot find empty slot => return 0
-	return NULL;
-}
-
-void gameObjInstDestroy(GameObj& pInst)
-{
-	// Lazy deletion, not really delete the object, just set it as inactive
-	if (pInst.flag == FLAG_INACTIVE)
-		return;
-
-	sNumGameObj--;
-	pInst.flag = FLAG_INACTIVE;
-}
-
-bool checkCollision(const GameObj& obj1, const GameObj& obj2) {
+// The old box test, two boxes of the size of the asteroid through the separating axes, kept for the benchmark
+bool checkCollisionBox(const glm::vec2& pos1, const glm::vec2& scale1, const glm::vec2& pos2) {
 	bool isCollision = true;
-	float width = obj1.scale.x / 2, height = obj1.scale.y / 2;
+	float width = scale1.x / 2, height = scale1.y / 2;
 
 	glm::vec2 vertices1[4] = {
-	   {obj1.position.x - width ,obj1.position.y + height },
-	   {obj1.position.x + width ,obj1.position.y + height },
-	   {obj1.position.x + width ,obj1.position.y - height },
-	   {obj1.position.x - width ,obj1.position.y - height },
+	   {pos1.x - width ,pos1.y + height },
+	   {pos1.x + width ,pos1.y + height },
+	   {pos1.x + width ,pos1.y - height },
+	   {pos1.x - width ,pos1.y - height },
 	},
 	vertices2[4] = {
-	   {obj2.position.x - width ,obj2.position.y + height },
-	   {obj2.position.x + width ,obj2.position.y + height },
-	   {obj2.position.x + width ,obj2.position.y - height },
-	   {obj2.position.x - width ,obj2.position.y - height },
+	   {pos2.x - width ,pos2.y + height },
+	   {pos2.x + width ,pos2.y + height },
+	   {pos2.x + width ,pos2.y - height },
+	   {pos2.x - width ,pos2.y - height },
 	};
 	glm::vec2 axises[4] = {};
 
@@ -172,23 +264,614 @@ bool checkCollision(const GameObj& obj1, const GameObj& obj2) {
 	return isCollision;
 }
 
-void restart() {
-	GameStateLevel1Free();
+// The asteroid circle (center, radius) against object j of obj, with the shape of its type
+//	- point: one squared distance, segment and capsule: the same from the closest point of the segment
+bool checkCollision(const glm::vec2& center, float radius, const GameObjArrays& obj, int j, int type) {
+	const CollisionShape& shape = sShape[type];
+	glm::vec2 d = center - obj.position[j];
 
-	//+ clear the game object instance array
-	memset(sGameObjInstArray, 0, sizeof(GameObj) * GAME_OBJ_INST_MAX);
+	if (shape.kind == SHAPE_POINT)
+		return glm::dot(d, d) <= radius * radius;
+	if (shape.kind == SHAPE_NONE)
+		return false;
+
+	float halfLength = shape.halfLength * obj.scale[j].y;
+	float t = glm::clamp(glm::dot(d, obj.direction[j]), -halfLength, halfLength);
+	d -= t * obj.direction[j];
+
+	float reach = radius + shape.radius * obj.scale[j].x;
+	return glm::dot(d, d) <= reach * reach;
+}
+
+// Unit vector turned by the angle of rot = (cos, sin), a complex multiplication
+//	- rot is built once per update, the result is pulled back to length 1 so the error does not add up
+glm::vec2 rotateDir(const glm::vec2& dir, const glm::vec2& rot) {
+	glm::vec2 result(dir.x * rot.x - dir.y * rot.y, dir.x * rot.y + dir.y * rot.x);
+	return result * (1.5f - 0.5f * glm::dot(result, result));
+}
+
+// Turn the unit vector dir toward the unit vector want, the short way, by at most the angle of rot
+glm::vec2 turnToward(const glm::vec2& dir, const glm::vec2& want, const glm::vec2& rot) {
+	if (glm::dot(dir, want) >= rot.x)
+		return want;
+
+	// want is on the left of dir when the cross product is positive, turn counterclockwise
+	float cross = dir.x * want.y - dir.y * want.x;
+	return rotateDir(dir, glm::vec2(rot.x, cross >= 0.0f ? rot.y : -rot.y));
+}
+
+// Call func(obj, c, first, num) on the objects of a type, UPDATE_BLOCK at a time, spread over the job system
+//	- obj is chunk c, the block is [first, first + num) in it
+//	- a block never crosses a chunk, the chunks of a bucket are full except the last one
+//	- func runs on several threads at once, it must only touch the objects of its block
+void forEachBlock(int type, const std::function<void(const GameObjArrays&, int, int, int)>& func) {
+	int numBlock = (GameObjCount(type) + UPDATE_BLOCK - 1) / UPDATE_BLOCK;
+
+	JobParallelFor(numBlock, PARALLEL_GRAIN, [&](int begin, int end) {
+		for (int b = begin; b < end; b++) {
+			int index = b * UPDATE_BLOCK;
+			int c = index >> GAME_OBJ_CHUNK_SHIFT;
+			int first = index & (GAME_OBJ_CHUNK_SIZE - 1);
+			int num = glm::min(UPDATE_BLOCK, GameObjChunkCount(type, c) - first);
+
+			func(GameObjChunkData(type, c), c, first, num);
+		}
+	});
+	sNumIteration += GameObjCount(type);
+}
+
+// Destroy the objects of the type that are out of the screen
+//	- GameObjDestroy() is not thread safe, this runs on the calling thread
+void destroyOutside(int type, int halfWidth, int halfHeight) {
+	for (int c = 0; c < GameObjNumChunk(type); c++) {
+		const GameObjArrays& obj = GameObjChunkData(type, c);
+		int count = GameObjChunkCount(type, c);
+
+		for (int i = 0; i < count; i++) {
+			int distance_x = abs(obj.position[i].x);
+			int distance_y = abs(obj.position[i].y);
+
+			if (distance_x > halfWidth || distance_y > halfHeight) {
+				GameObjDestroy(obj.handle[i]);
+			}
+		}
+	}
+}
 
-	// Set the ship object instance to NULL
-	sPlayer = NULL;
+// Integrate, handle the screen edge and rebuild the modelMatrix of the type in one pass
+//	- the matrices are built while the block is still in cache
+//	- halfWidth/halfHeight: the screen edges are at +-half
+void updatePass(int type, float dt, int halfWidth, int halfHeight) {
+	int edge = sEdgeMode[type];
 
-	GameStateLevel1Init();
+	forEachBlock(type, [&](const GameObjArrays& obj, int, int first, int num) {
+		GameObjIntegrate(obj, first, num, dt, halfWidth, halfHeight, edge == EDGE_WRAP);
+		for (int i = first; i < first + num; i++) {
+			obj.modelMatrix[i] = GameObjModelMatrix(obj.position[i], obj.scale[i], obj.direction[i]);
+		}
+	});
+
+	if (edge == EDGE_KILL)
+		destroyOutside(type, halfWidth, halfHeight);
 }
 
+// -------------------------------------------
+// Update and draw phases, the nodes of sUpdateGraph and sDrawGraph
+// -------------------------------------------
+
+// Get user input, main thread
+void phaseInput() {
+
+	// the chunks never move, so the ship arrays stay valid while bullets are created
+	int player;
+	const GameObjArrays& ship = GameObjFind(sPlayer, player);
+
+	//-----------------------------------------
+	// Get user input
+	//-----------------------------------------
+
+	// Moving the Player
+	//	- WS accelereate/deaccelerate the ship
+	if (GameInputKey(GLFW_KEY_W)) {
+
+		// find acceleration vector
+		glm::vec2 acc = SHIP_ACC_FWD * ship.direction[player];
+
+		// use acceleration to change velocity
+		ship.velocity[player] += acc * sTickDt;
+
+		//+ velocity cap to MAX_SHIP_VELOCITY
+		if (glm::length(ship.velocity[player]) > MAX_SHIP_VELOCITY) {
+			ship.velocity[player] = glm::normalize(ship.velocity[player]) * MAX_SHIP_VELOCITY;
+		}
+
+	}
+	if (GameInputKey(GLFW_KEY_S)) {
+		// find acceleration vector
+		glm::vec2 acc = SHIP_ACC_FWD * ship.direction[player];
+
+		// use acceleration to change velocity
+		ship.velocity[player] -= acc * sTickDt;
+
+		//+ velocity cap to MAX_SHIP_VELOCITY
+		if (glm::length(ship.velocity[player]) > MAX_SHIP_VELOCITY) {
+			ship.velocity[player] = glm::normalize(ship.velocity[player]) * MAX_SHIP_VELOCITY;
+		}
+
+	}
+
+	//+ AD: turn the ship, counterclockwise by rot or clockwise by its conjugate
+	glm::vec2 rot(glm::cos(sTickDt * SHIP_ROT_SPEED), glm::sin(sTickDt * SHIP_ROT_SPEED));
+	if (GameInputKey(GLFW_KEY_A)) {
+		ship.direction[player] = rotateDir(ship.direction[player], rot);
+	}
+	if (GameInputKey(GLFW_KEY_D)) {
+		ship.direction[player] = rotateDir(ship.direction[player], glm::vec2(rot.x, -rot.y));
+
+	}
+
+	// Fire bullet/missile using JK
+	//	- create the bullet at the ship's position
+	//	- bullet direction is the same as the ship's direction
+	//	- at most one per BULLET_FIRE_INTERVAL/MISSILE_FIRE_INTERVAL seconds whatever the tick rate,
+	//	  fired on the update nearest to the end of the cooldown
+	//	- creating only appends to the arrays, the player index stays valid
+	sBulletCooldown = glm::max(sBulletCooldown - sTickDt, 0.0f);
+	sMissileCooldown = glm::max(sMissileCooldown - sTickDt, 0.0f);
+	if (GameInputKey(GLFW_KEY_J) && sBulletCooldown < 0.5f * sTickDt) {
+		sBulletCooldown += BULLET_FIRE_INTERVAL;
+
+		//+ find the bullet velocity vector
+		glm::vec2 bullet_velocity = BULLET_SPEED * ship.direction[player];
+
+		//+ call GameObjCreate() to create a bullet
+		GameObjCreate(TYPE_BULLET, ship.position[player], bullet_velocity,
+			glm::vec2(25.0f, 25.0f), ship.direction[player]);
+	}
+	if (GameInputKey(GLFW_KEY_K) && sMissileCooldown < 0.5f * sTickDt) {
+		sMissileCooldown += MISSILE_FIRE_INTERVAL;
+
+		//+ find the bullet velocity vector
+		glm::vec2 bullet_velocity = BULLET_SPEED * ship.direction[player];
+
+		//+ call GameObjCreate() to create a bullet
+		GameObjCreate(TYPE_MISSILE, ship.position[player], bullet_velocity,
+			glm::vec2(25.0f, 25.0f), ship.direction[player]);
+	}
+
+	// Cam zoom UI, for Debugging
+	if (GameInputKey(GLFW_KEY_U)) {
+		ZoomIn(0.1f);
+	}
+	if (GameInputKey(GLFW_KEY_I)) {
+		ZoomOut(0.1f);
+	}
+}
+
+// Turn the missiles [first, first + num) toward their target, an AI task run by phaseSteer()
+//	- a missile keeps its target until the target is destroyed or leaves the lock cone
+//	- then it looks for the closest asteroid ahead (the closest one at all when none is ahead),
+//	  about once every HOMING_MISSILE_RETARGET updates, at a different update for each missile
+//	- numTick = updates since the last visit, when the AI is behind the missiles turn further per visit
+void steerMissiles(const GameObjArrays& obj, int first, int num, int numTick) {
+
+	// the turn since the last visit as a rotation, the same for every missile
+	float turn = glm::min(HOMING_MISSILE_ROT_SPEED * sTickDt * numTick, PI);
+	glm::vec2 rot(glm::cos(turn), glm::sin(turn));
+
+	for (int i = first; i < first + num; i++) {
+		glm::vec2 heading = obj.direction[i];
+
+		GameObjHandle	target = obj.target[i];
+		glm::vec2		targetPos;
+		bool			locked = false;
+		if (GameObjIsValid(target)) {
+			int t;
+			targetPos = GameObjFind(target, t).position[t];
+			glm::vec2 d = targetPos - obj.position[i];
+			locked = glm::dot(d, heading) >= HOMING_MISSILE_COS_LOCK * glm::length(d);
+		}
+
+		if (!locked) {
+			target = GAME_OBJ_HANDLE_NONE;
+
+			// the turn of the missile comes once in HOMING_MISSILE_RETARGET updates, it may fall between two visits
+			if ((obj.handle[i] + sTickFrame) % HOMING_MISSILE_RETARGET < (unsigned int)numTick) {
+				SpatialGridHit hit[HOMING_MISSILE_NUM_HIT];
+				int numHit = SpatialGridNearestInCone(sAsteroidGrid, obj.position[i], heading, HOMING_MISSILE_COS_CONE,
+					FLT_MAX, HOMING_MISSILE_NUM_HIT, hit);
+				if (numHit == 0)
+					numHit = SpatialGridNearest(sAsteroidGrid, obj.position[i], FLT_MAX, HOMING_MISSILE_NUM_HIT, hit);
+
+				for (int k = 0; k < numHit; k++) {
+					if (GameObjIsValid(hit[k].handle)) {
+						int t;
+						target = hit[k].handle;
+						targetPos = GameObjFind(target, t).position[t];
+						break;
+					}
+				}
+			}
+			obj.target[i] = target;
+		}
+
+		// fly straight on while there is no target
+		if (target == GAME_OBJ_HANDLE_NONE)
+			continue;
+
+		// Calculate the direction vector from the object's position to the target point
+		glm::vec2 toTarget = targetPos - obj.position[i];
+		float distance2 = glm::dot(toTarget, toTarget);
+		if (distance2 > 0.0f) {
+			obj.direction[i] = turnToward(obj.direction[i], toTarget * glm::inversesqrt(distance2), rot);
+		}
+
+		obj.velocity[i] = BULLET_SPEED * obj.direction[i];
+	}
+	sNumIteration += num;
+}
+
+// Update the velocity of the ship and missiles
+void phaseSteer() {
+
+	// the missiles look for their target in the asteroid grid
+	//	- only when there are missiles, the build reads every asteroid
+	//	- a few updates old at most, the search only picks the target, the missile steers to where it is now
+	bool rebuild = sTickFrame % HOMING_MISSILE_RETARGET == 0 || SpatialGridCount(sAsteroidGrid) == 0;
+	if (GameObjCount(TYPE_MISSILE) > 0 && rebuild) {
+		glm::vec2 half(GetWindowWidth() / 2, GetWindowHeight() / 2);
+		SpatialGridBuild(sAsteroidGrid, TYPE_ASTEROID, -half, half, SPATIAL_GRID_CELL_AUTO);
+	}
+
+	//---------------------------------------------------------
+	// Update the velocity of the ship and missiles
+	//---------------------------------------------------------
+
+	//+ for ship: add some friction to slow it down, SHIP_FRICTION per 1/60 s whatever the tick rate
+	float friction = glm::pow(SHIP_FRICTION, sTickDt * 60.0f);
+	for (int c = 0; c < GameObjNumChunk(TYPE_SHIP); c++) {
+		const GameObjArrays& obj = GameObjChunkData(TYPE_SHIP, c);
+		int count = GameObjChunkCount(TYPE_SHIP, c);
+
+		for (int i = 0; i < count; i++) {
+			obj.velocity[i] *= friction;
+		}
+		sNumIteration += count;
+	}
+
+	//+ for missiles and the other AI: as many as the AI budget allows, see steerMissiles()
+	AISchedulerRun();
+}
+
+// Update all game obj position using velocity, and their modelMatrix
+//	- wrap ship and asteroid around the screen
+//	- destroy bullet and missile that go out of the screen
+//	- the collision does not move the objects, a destroyed object keeps its matrix until the flush removes it
+//	- one node per group of buckets, the bullets are queued for destroy before the missiles, as they always were
+void phaseIntegrate(int type) {
+	updatePass(type, sTickDt, GetWindowWidth() / 2, GetWindowHeight() / 2);
+}
+
+// Find the asteroid/target pairs that may collide, O(n^2)
+//	- every asteroid against the ship, bullet and missile buckets
+//	- the target positions in the box position +- scale of the asteroid, it holds the shapes that can touch, see sShape
+//	- the shapes of a pair are tested when it is found, pair by pair
+void broadphaseLoop(std::vector<CollisionPair>& pairs) {
+	for (int c1 = 0; c1 < GameObjNumChunk(TYPE_ASTEROID); c1++) {
+		const GameObjArrays& obj1 = GameObjChunkData(TYPE_ASTEROID, c1);
+		int count1 = GameObjChunkCount(TYPE_ASTEROID, c1);
+
+		for (int i = 0; i < count1; i++) {
+			sNumIteration++;
+
+			for (int k = 0; k < NUM_TARGET_TYPE; k++) {
+				int type = sTargetType[k];
+
+				for (int c2 = 0; c2 < GameObjNumChunk(type); c2++) {
+					const GameObjArrays& obj2 = GameObjChunkData(type, c2);
+					int count2 = GameObjChunkCount(type, c2);
+
+					for (int j = 0; j < count2; j++) {
+						glm::vec2 d = glm::abs(obj1.position[i] - obj2.position[j]);
+						if (d.x <= obj1.scale[i].x && d.y <= obj1.scale[i].y) {
+							CollisionPair pair = { obj1.handle[i], obj2.handle[j], type,
+								checkCollision(obj1.position[i], sShape[TYPE_ASTEROID].radius * obj1.scale[i].x, obj2, j, type) };
+							pairs.push_back(pair);
+						}
+					}
+					sNumIteration += count2;
+				}
+			}
+		}
+	}
+}
+
+// Stable counting sort of sIndexedPairs by key(pair), in [0, numKey)
+template <typename KeyFunc>
+void sortIndexedPairs(int numKey, KeyFunc key) {
+	sPairStart.assign(numKey + 1, 0);
+	for (size_t n = 0; n < sIndexedPairs.size(); n++) {
+		sPairStart[key(sIndexedPairs[n]) + 1]++;
+	}
+	for (int k = 0; k < numKey; k++) {
+		sPairStart[k + 1] += sPairStart[k];
+	}
+
+	sSortedPairs.resize(sIndexedPairs.size());
+	for (size_t n = 0; n < sIndexedPairs.size(); n++) {
+		sSortedPairs[sPairStart[key(sIndexedPairs[n])]++] = sIndexedPairs[n];
+	}
+	sIndexedPairs.swap(sSortedPairs);
+}
+
+// Append sIndexedPairs in the order of broadphaseLoop(): by asteroid, then by target
+//	- the first pair of an asteroid is the one that destroys it, so the game plays the same with any broadphase
+//	- byTarget = false when they are already by target
+void appendIndexedPairs(std::vector<CollisionPair>& pairs, bool byTarget) {
+	if (byTarget) {
+		int numTarget = 0;
+		for (int k = 0; k < NUM_TARGET_TYPE; k++) {
+			numTarget += GameObjCount(sTargetType[k]);
+		}
+		sortIndexedPairs(numTarget, [](const IndexedPair& p) { return p.target; });
+	}
+	sortIndexedPairs(GameObjCount(TYPE_ASTEROID), [](const IndexedPair& p) { return p.asteroid; });
+
+	for (size_t n = 0; n < sIndexedPairs.size(); n++) {
+		pairs.push_back(sIndexedPairs[n].pair);
+	}
+}
+
+// Test the shape of target j against the circles of the candidate asteroids (bucket indices)
+//	- bit n of outMask = candidate n touches, the same as checkCollision() on each
+//	- the circles are gathered SoA, CollisionKernel tests 8 or 16 of them per instruction
+void testCandidates(const GameObjArrays& obj, int j, int type, const std::vector<int>& candidate, std::vector<uint32_t>& outMask) {
+	static thread_local std::vector<float> x, y, radius;
+	int num = (int)candidate.size();
+	outMask.assign((num + 31) / 32, 0);
+	x.resize(num);
+	y.resize(num);
+	radius.resize(num);
+
+	for (int n = 0; n < num; n++) {
+		int a = candidate[n];
+		const GameObjArrays& asteroid = GameObjChunkData(TYPE_ASTEROID, a >> GAME_OBJ_CHUNK_SHIFT);
+		int i = a & (GAME_OBJ_CHUNK_SIZE - 1);
+		x[n] = asteroid.position[i].x;
+		y[n] = asteroid.position[i].y;
+		radius[n] = sShape[TYPE_ASTEROID].radius * asteroid.scale[i].x;
+	}
+
+	const CollisionShape& shape = sShape[type];
+	if (shape.kind == SHAPE_POINT)
+		CollisionPointCircles(obj.position[j], x.data(), y.data(), radius.data(), num, outMask.data());
+	else if (shape.kind != SHAPE_NONE)
+		CollisionCapsuleCircles(obj.position[j], obj.direction[j], shape.halfLength * obj.scale[j].y, shape.radius * obj.scale[j].x,
+			x.data(), y.data(), radius.data(), num, outMask.data());
+}
+
+// The targets against the asteroids, overlap(pos, outIndex) appends the asteroids whose box holds pos
+//	- the targets are queried in parallel, each block keeps its pairs, the blocks are joined in order
+//	- the candidates of a target are tested in one go, see testCandidates()
+template <typename OverlapFunc>
+void queryTargets(std::vector<CollisionPair>& pairs, OverlapFunc overlap) {
+	sIndexedPairs.clear();
+
+	int targetFirst = 0;
+	for (int k = 0; k < NUM_TARGET_TYPE; k++) {
+		int type = sTargetType[k];
+		int numBlock = (GameObjCount(type) + UPDATE_BLOCK - 1) / UPDATE_BLOCK;
+		if ((int)sBlockPairs.size() < numBlock)
+			sBlockPairs.resize(numBlock);
+
+		forEachBlock(type, [&](const GameObjArrays& obj, int c, int first, int num) {
+			static thread_local std::vector<int> candidate;
+			static thread_local std::vector<uint32_t> hitMask;
+			std::vector<IndexedPair>& blockPairs = sBlockPairs[((c << GAME_OBJ_CHUNK_SHIFT) + first) / UPDATE_BLOCK];
+			blockPairs.clear();
+
+			for (int j = first; j < first + num; j++) {
+				candidate.clear();
+				overlap(obj.position[j], candidate);
+				testCandidates(obj, j, type, candidate, hitMask);
+				for (size_t n = 0; n < candidate.size(); n++) {
+					int a = candidate[n];
+					const GameObjArrays& asteroid = GameObjChunkData(TYPE_ASTEROID, a >> GAME_OBJ_CHUNK_SHIFT);
+					IndexedPair indexed = { a, targetFirst + (c << GAME_OBJ_CHUNK_SHIFT) + j,
+						{ asteroid.handle[a & (GAME_OBJ_CHUNK_SIZE - 1)], obj.handle[j], type, ((hitMask[n >> 5] >> (n & 31)) & 1) != 0 } };
+					blockPairs.push_back(indexed);
+				}
+			}
+		});
+
+		for (int b = 0; b < numBlock; b++) {
+			sIndexedPairs.insert(sIndexedPairs.end(), sBlockPairs[b].begin(), sBlockPairs[b].end());
+		}
+		targetFirst += GameObjCount(type);
+	}
+
+	appendIndexedPairs(pairs, false);
+}
+
+// Same pairs in the same order from a grid of the asteroids, about O(n + m)
+//	- the cells are as large as the asteroids, a target only reads the 3x3 cells around it
+void broadphaseGrid(std::vector<CollisionPair>& pairs, int halfWidth, int halfHeight) {
+	SpatialGridBuild(sCollisionGrid, TYPE_ASTEROID, glm::vec2(-halfWidth, -halfHeight), glm::vec2(halfWidth, halfHeight),
+		SPATIAL_GRID_CELL_SCALE);
+	sNumIteration += GameObjCount(TYPE_ASTEROID);
+
+	queryTargets(pairs, [](glm::vec2 pos, std::vector<int>& outIndex) {
+		SpatialGridOverlap(sCollisionGrid, pos, glm::vec2(0.0f), outIndex);
+	});
+}
+
+// Same pairs in the same order from the Box2D tree of the asteroids, about O(m log n)
+//	- an asteroid is only reinserted when it leaves its fat box, ASTEROID_SPEED moves it a few units an update
+void broadphaseTree(std::vector<CollisionPair>& pairs) {
+	AabbTreeUpdate(sCollisionTree);
+	sNumIteration += AabbTreeCount(sCollisionTree);
+
+	queryTargets(pairs, [](glm::vec2 pos, std::vector<int>& outIndex) {
+		AabbTreeOverlap(sCollisionTree, pos, glm::vec2(0.0f), outIndex);
+	});
+}
+
+// Same pairs in the same order from the sweep and prune, on one thread
+//	- the asteroids move little in an update, re-sorting the last order is about O(n)
+//	- a target is tested against the asteroids whose box spans its x, the shapes of the pairs one by one
+void broadphaseSweepPrune(std::vector<CollisionPair>& pairs) {
+	SweepPruneUpdate(sSweepPrune);
+	sNumIteration += SweepPruneCount(sSweepPrune);
+
+	sSweepPairs.clear();
+	SweepPruneFindPairs(sSweepPrune, sSweepPairs);
+
+	int targetFirst[NUM_TARGET_TYPE];
+	for (int k = 0; k < NUM_TARGET_TYPE; k++) {
+		targetFirst[k] = (k == 0) ? 0 : targetFirst[k - 1] + GameObjCount(sTargetType[k - 1]);
+	}
+
+	sIndexedPairs.resize(sSweepPairs.size());
+	for (size_t n = 0; n < sSweepPairs.size(); n++) {
+		const SweepPrunePair& sweep = sSweepPairs[n];
+		int type = sTargetType[sweep.group];
+		const GameObjArrays& asteroid = GameObjChunkData(TYPE_ASTEROID, sweep.boxIndex >> GAME_OBJ_CHUNK_SHIFT);
+		const GameObjArrays& target = GameObjChunkData(type, sweep.pointIndex >> GAME_OBJ_CHUNK_SHIFT);
+		int i = sweep.boxIndex & (GAME_OBJ_CHUNK_SIZE - 1);
+		bool hit = checkCollision(asteroid.position[i], sShape[TYPE_ASTEROID].radius * asteroid.scale[i].x,
+			target, sweep.pointIndex & (GAME_OBJ_CHUNK_SIZE - 1), type);
+
+		IndexedPair indexed = { sweep.boxIndex, targetFirst[sweep.group] + sweep.pointIndex,
+			{ sweep.box, sweep.point, type, hit } };
+		sIndexedPairs[n] = indexed;
+	}
+
+	appendIndexedPairs(pairs, true);
+}
+
+void runBroadphase(int mode, std::vector<CollisionPair>& pairs, int halfWidth, int halfHeight) {
+	if (mode == BROADPHASE_GRID)
+		broadphaseGrid(pairs, halfWidth, halfHeight);
+	else if (mode == BROADPHASE_SAP)
+		broadphaseSweepPrune(pairs);
+	else if (mode == BROADPHASE_TREE)
+		broadphaseTree(pairs);
+	else
+		broadphaseLoop(pairs);
+}
+
+// Find the asteroid/target pairs that may collide, with the broadphase picked by --broadphase
+void phaseBroadphase() {
+	sPairs.clear();
+	runBroadphase(sBroadphase, sPairs, GetWindowWidth() / 2, GetWindowHeight() / 2);
+}
+
+// Apply the hits of the pairs
+//	- the broadphase tested the shapes of the pairs where it found them, the candidates of a target
+//	  in one batch, the objects have not moved since
+//	- GameObjDestroy() only queues the objects, so the buckets stay the same during the loop,
+//	  an asteroid or a bullet hit by an earlier pair is still there and has to be skipped
+void phaseNarrowphase() {
+	for (size_t k = 0; k < sPairs.size(); k++) {
+		const CollisionPair& pair = sPairs[k];
+		if (!pair.hit || !GameObjIsValid(pair.obj1) || !GameObjIsValid(pair.obj2))
+			continue;
+
+		//+ Update game behavior and the game object arrays
+		GameObjDestroy(pair.obj1);
+
+		if (pair.type2 == TYPE_SHIP) {
+			// out of lives => ask main to restart the level after this frame
+			if (--sPlayerLives <= 0) {
+				sTickState = 2;
+			}
+		}
+		else {
+			// bullet or missile
+			GameObjDestroy(pair.obj2);
+		}
+	}
+}
+
+// remove everything destroyed in this frame in one go
+void phaseFlush() {
+	GameObjFlush(true);
+}
+
+// Interpolate the modelMatrix of every object, in draw order
+//	- the modelMatrix is from the last update, move it to where the object is between the last two updates
+void phaseDrawList() {
+	sDrawFirst[0] = 0;
+	for (int k = 0; k < NUM_TYPE; k++) {
+		sDrawFirst[k + 1] = sDrawFirst[k] + GameObjCount(sDrawOrder[k]);
+	}
+	sDrawList.resize(sDrawFirst[NUM_TYPE]);
+
+	for (int k = 0; k < NUM_TYPE; k++) {
+		glm::mat4* pList = sDrawList.data() + sDrawFirst[k];
+
+		forEachBlock(sDrawOrder[k], [&](const GameObjArrays& obj, int c, int first, int num) {
+			glm::mat4* pDst = pList + (c << GAME_OBJ_CHUNK_SHIFT);
+			for (int i = first; i < first + num; i++) {
+				pDst[i] = obj.modelMatrix[i];
+				pDst[i][3] = glm::vec4(glm::mix(obj.prevPosition[i], obj.position[i], sDrawAlpha), 0.0f, 1.0f);
+			}
+		});
+	}
+}
+
+// Draw the list, main thread
+void phaseSubmit() {
+
+	// Clear the screen
+	ClearScreen(0.5f, 0.5f, 0.5f);
+
+	// draw all active game object instance, bucket by bucket
+	for (int k = 0; k < NUM_TYPE; k++) {
+		int type = sDrawOrder[k];
+
+		for (int i = sDrawFirst[k]; i < sDrawFirst[k + 1]; i++) {
+
+			// 4 steps to draw sprites on the screen
+			//	1. SetRenderMode()
+			//	2. SetTexture()
+			//	3. SetTransform()
+			//	4. DrawMesh()
+
+			SetRenderMode(CDT_TEXTURE, 1.0f);
+			SetTexture(sTexArray[type], 0.0f, 0.0f);
+			SetTransform(sDrawList[i]);
+			DrawMesh(sMeshArray[type]);
+		}
+	}
+
+	// Swap the buffer, to present the drawing
+	SystemSwapBuffers();
+}
 
 // -------------------------------------------
 // Game states function
 // -------------------------------------------
 
+void GameStateLevel1SetNumAsteroid(int num) {
+	sNumAsteroid = (num < 0) ? 0 : num;
+}
+
+int GameStateLevel1GetNumAsteroid(void) {
+	return sNumAsteroid;
+}
+
+bool GameStateLevel1SetBroadphase(const char* name) {
+	for (int mode = 0; mode < NUM_BROADPHASE; mode++) {
+		if (strcmp(name, sBroadphaseName[mode]) == 0) {
+			sBroadphaseArg = mode;
+			return true;
+		}
+	}
+	return false;
+}
+
+
 void GameStateLevel1Load(void) {
 
 	// clear the Mesh array
@@ -199,10 +882,10 @@ void GameStateLevel1Load(void) {
 	memset(sTexArray, 0, sizeof(CDTTex) * TEXTURE_MAX);
 
 	//+ clear the game object instance array
-	memset(sGameObjInstArray, 0, sizeof(GameObj) * GAME_OBJ_INST_MAX);
+	GameObjReset();
 
-	// Set the ship object instance to NULL
-	sPlayer = NULL;
+	// Set the ship object instance to none
+	sPlayer = GAME_OBJ_HANDLE_NONE;
 
 
 	// --------------------------------------------------------------------------
@@ -259,406 +942,849 @@ void GameStateLevel1Load(void) {
 	*pTex = TextureLoad("missile.png");
 
 
-
-	printf("Level1: Load\n");
+	sAsteroidGrid = SpatialGridCreate();
+	sCollisionGrid = SpatialGridCreate();
+	sSweepPrune = SweepPruneCreate(TYPE_ASTEROID, sTargetType, NUM_TARGET_TYPE);
+	sCollisionTree = AabbTreeCreate(TYPE_ASTEROID, ASTEROID_TREE_MARGIN);
+	AISchedulerAdd("missile steering", TYPE_MISSILE, steerMissiles);
+
+	// the phases of Update() and Draw(), each runs once every node it depends on is done
+	//	- the bullets move while the missiles steer, they only need the input
+	//	- the asteroids move once the missiles have read where they are, while the ship, background and missiles move
+	sUpdateGraph = TaskGraphCreate("Level1 update");
+	TaskGraphAdd(sUpdateGraph, "input", 0, RES_INPUT | RES_SHIP | RES_BULLET | RES_MISSILE, true, phaseInput);
+	TaskGraphAdd(sUpdateGraph, "steer", RES_ASTEROID, RES_SHIP | RES_MISSILE | RES_TARGET, false, phaseSteer);
+	TaskGraphAdd(sUpdateGraph, "integrate bullets", 0, RES_BULLET | RES_DESTROY, false, []() {
+		phaseIntegrate(TYPE_BULLET);
+	});
+	TaskGraphAdd(sUpdateGraph, "integrate asteroids", 0, RES_ASTEROID, false, []() {
+		phaseIntegrate(TYPE_ASTEROID);
+	});
+	TaskGraphAdd(sUpdateGraph, "integrate others", 0, RES_SHIP | RES_MISSILE | RES_BACKGROUND | RES_DESTROY, false, []() {
+		phaseIntegrate(TYPE_SHIP);
+		phaseIntegrate(TYPE_BACKGROUND);
+		phaseIntegrate(TYPE_MISSILE);
+	});
+	TaskGraphAdd(sUpdateGraph, "broadphase", RES_SHIP | RES_BULLET | RES_ASTEROID | RES_MISSILE, RES_PAIRS, false, phaseBroadphase);
+	TaskGraphAdd(sUpdateGraph, "narrowphase", RES_OBJECTS | RES_PAIRS, RES_DESTROY, false, phaseNarrowphase);
+	TaskGraphAdd(sUpdateGraph, "flush", 0, RES_OBJECTS | RES_DESTROY, false, phaseFlush);
+
+	sDrawGraph = TaskGraphCreate("Level1 draw");
+	TaskGraphAdd(sDrawGraph, "draw list", RES_OBJECTS, RES_DRAW_LIST, false, phaseDrawList);
+	TaskGraphAdd(sDrawGraph, "submit", RES_DRAW_LIST, RES_SCREEN, true, phaseSubmit);
+
+	// the loop is faster for the few asteroids of a game, the grid for the --asteroids stress runs
+	if (sBroadphaseArg >= 0)
+		sBroadphase = sBroadphaseArg;
+	else
+		sBroadphase = (sNumAsteroid >= BROADPHASE_GRID_MIN) ? BROADPHASE_GRID : BROADPHASE_LOOP;
+	printf("Level1: Load, %s broadphase\n", sBroadphaseName[sBroadphase]);
 }
 
 
 void GameStateLevel1Init(void) {
 
-	srand(time(NULL));
+	GameRandomSeed(sRandom, GameRandomGetSeed());
+	AISchedulerReset();
 
 	//+ Create the background instance
-	//	- Creation order is important when rendering, so we should create the background first
-	sBackground = gameObjInstCreate(TYPE_BACKGROUND, glm::vec3(0.0f, 0.0f, 0.0f),
-		glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(GetWindowWidth(), GetWindowHeight(), 1.0f), 0.0f);
+	//	- Drawing order comes from sDrawOrder, the background bucket is drawn first
+	sBackground = GameObjCreate(TYPE_BACKGROUND, glm::vec2(0.0f, 0.0f),
+		glm::vec2(0.0f, 0.0f), glm::vec2(GetWindowWidth(), GetWindowHeight()), glm::vec2(0.0f, 1.0f));
 
 	// Create player game object instance
-	//	- the position.z should be set to 0
-	//	- the scale.z should be set to 1
-	//	- the velocity.z should be set to 0
-	sPlayer = gameObjInstCreate(TYPE_SHIP, glm::vec3(0.0f, -GetWindowHeight() / 4, 0.0f),
-		glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(50.0f, 50.0f, 1.0f), 0.0f);
-
-	//+ Create all asteroid instance, NUM_ASTEROID, with random pos and velocity
-	//	- int a = rand() % 30 + 20;							// a is in the range 20-50
-	//	- float b = (float)rand()/(float)(RAND_MAX);		// b is the range 0..1
-	for (int i = 0; i < NUM_ASTEROID; i++)
+	//	- objects are stored in 2D, z is added back when the modelMatrix is built
+	sPlayer = GameObjCreate(TYPE_SHIP, glm::vec2(0.0f, -GetWindowHeight() / 4),
+		glm::vec2(0.0f, 0.0f), glm::vec2(50.0f, 50.0f), glm::vec2(0.0f, 1.0f));
+
+	//+ Create all asteroid instance, sNumAsteroid (NUM_ASTEROID unless --asteroids), with random pos and velocity
+	//	- int a = GameRandomInt(sRandom, 30) + 20;			// a is in the range 20-50
+	//	- float b = GameRandomFloat(sRandom);				// b is the range 0..1
+	//	- the whole field is created by one GameObjCreateBatch() call
+	std::vector<glm::vec2> position(sNumAsteroid);
+	std::vector<glm::vec2> velocity(sNumAsteroid);
+	for (int i = 0; i < sNumAsteroid; i++)
 	{
-		float x_position = -(GetWindowWidth() / 2) + rand() % GetWindowWidth();
-		float y_position = (rand() % GetWindowHeight()) / 2;
+		float x_position = -(GetWindowWidth() / 2) + GameRandomInt(sRandom, GetWindowWidth());
+		float y_position = GameRandomInt(sRandom, GetWindowHeight()) / 2;
 
-		float x_velocity = -ASTEROID_SPEED + rand() % (int)(ASTEROID_SPEED * 2);
-		float y_velocity = -ASTEROID_SPEED + rand() % (int)(ASTEROID_SPEED * 2);
+		float x_velocity = -ASTEROID_SPEED + GameRandomInt(sRandom, (int)(ASTEROID_SPEED * 2));
+		float y_velocity = -ASTEROID_SPEED + GameRandomInt(sRandom, (int)(ASTEROID_SPEED * 2));
 
-		gameObjInstCreate(TYPE_ASTEROID, glm::vec3(x_position, y_position, 0.0f),
-			glm::vec3(x_velocity, y_velocity, 0.0f), glm::vec3(50.0f, 50.0f, 1.0f), 0.0f);
+		position[i] = glm::vec2(x_position, y_position);
+		velocity[i] = glm::vec2(x_velocity, y_velocity);
 	}
+	GameObjCreateBatch(TYPE_ASTEROID, sNumAsteroid, position.data(), velocity.data(),
+		glm::vec2(50.0f, 50.0f), glm::vec2(0.0f, 1.0f), NULL);
 
 
 
 	//+ reset the score and player life
 	sScore = 0;
 	sPlayerLives = PLAYER_INITIAL_NUM;
+	sBulletCooldown = 0.0f;
+	sMissileCooldown = 0.0f;
 
-	printf("Level1: Init\n");
+	printf("Level1: Init, seed %llu\n", (unsigned long long)GameRandomGetSeed());
 }
 
 
 void GameStateLevel1Update(double dt, long frame, int& state) {
 
-	//-----------------------------------------
-	// Get user input
-	//-----------------------------------------
-
-	// Moving the Player
-	//	- WS accelereate/deaccelerate the ship
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+	sTickDt = (float)dt;
+	sTickFrame = frame;
+	sTickState = state;
+	sNumIteration = 0;
 
-		// find acceleration vector
-		glm::vec3 acc = glm::vec3(SHIP_ACC_FWD * glm::cos(sPlayer->orientation + PI / 2.0f),
-			SHIP_ACC_FWD * glm::sin(sPlayer->orientation + PI / 2.0f), 0);
+	// input -> steer -> integrate -> broadphase -> narrowphase -> flush, the transforms next to the collision
+	TaskGraphRun(sUpdateGraph);
 
-		// use acceleration to change velocity
-		sPlayer->velocity += acc * glm::vec3(dt, dt, 0.0f);
+	state = sTickState;
 
-		//+ velocity cap to MAX_SHIP_VELOCITY
-		if (glm::length(sPlayer->velocity) > MAX_SHIP_VELOCITY) {
-			sPlayer->velocity = glm::normalize(sPlayer->velocity) * MAX_SHIP_VELOCITY;
+#if SHOW_ITERATION_COUNT
+	if (sTickFrame % 60 == 0) {
+		int numObj = 0;
+		for (int type = 0; type < NUM_TYPE; type++) {
+			numObj += GameObjCount(type);
 		}
-
+		printf("Iteration> %ld objects visited for %d active\n", sNumIteration.load(), numObj);
 	}
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-		// find acceleration vector
-		glm::vec3 acc = glm::vec3(SHIP_ACC_FWD * glm::cos(sPlayer->orientation + PI / 2.0f),
-			SHIP_ACC_FWD * glm::sin(sPlayer->orientation + PI / 2.0f), 0);
+#endif
 
-		// use acceleration to change velocity
-		sPlayer->velocity -= acc * glm::vec3(dt, dt, 0.0f);
+	//printf("Life> %i\n", sPlayerLives);
+	//printf("Score> %i\n", sScore);
+}
 
-		//+ velocity cap to MAX_SHIP_VELOCITY
-		if (glm::length(sPlayer->velocity) > MAX_SHIP_VELOCITY) {
-			sPlayer->velocity = glm::normalize(sPlayer->velocity) * MAX_SHIP_VELOCITY;
-		}
+void GameStateLevel1Draw(double alpha) {
 
-	}
+	sDrawAlpha = (float)alpha;
+	TaskGraphRun(sDrawGraph);
+}
 
-	//+ AD: turn the ship
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-		sPlayer->orientation += dt * SHIP_ROT_SPEED;
-	}
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-		sPlayer->orientation -= dt * SHIP_ROT_SPEED;
+void GameStateLevel1Free(void) {
 
-	}
+	//+ destroy all object instances, the ids are handed out from 0 again by the next Init
+	GameObjReset();
 
-	// Fire bullet/missile using JK
-	//	- create the bullet at the ship's position
-	//	- bullet direction is the same as the ship's orientation
-	//	- may use if(frame % n == 0) too slow down the bullet creation
-	if (glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS && frame % 8 == 0) {
-		//+ find the bullet velocity vector
-		glm::vec3 bullet_velocity = glm::vec3(BULLET_SPEED * glm::cos(sPlayer->orientation + PI / 2.0f),
-			BULLET_SPEED * glm::sin(sPlayer->orientation + PI / 2.0f), 0);
+	// reset camera
+	ResetCam();
 
-		//+ call gameObjInstCreate() to create a bullet
-		gameObjInstCreate(TYPE_BULLET, sPlayer->position, bullet_velocity,
-			glm::vec3(25.0f, 25.0f, 1.0f), sPlayer->orientation);
-	}
-	if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS && frame % 10 == 0) {
-		//+ find the bullet velocity vector
-		glm::vec3 bullet_velocity = glm::vec3(BULLET_SPEED * glm::cos(sPlayer->orientation + PI / 2.0f),
-			BULLET_SPEED * glm::sin(sPlayer->orientation + PI / 2.0f), 0);
+	printf("Level1: Free\n");
+}
 
-		//+ call gameObjInstCreate() to create a bullet
-		gameObjInstCreate(TYPE_MISSILE, sPlayer->position, bullet_velocity,
-			glm::vec3(25.0f, 25.0f, 1.0f), sPlayer->orientation);
-	}
+void GameStateLevel1Unload(void) {
 
-	// Cam zoom UI, for Debugging
-	if (glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS) {
-		ZoomIn(0.1f);
-	}
-	if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS) {
-		ZoomOut(0.1f);
+	// Unload all meshes in MeshArray
+	for (int i = 0; i < sNumMesh; i++) {
+		UnloadMesh(sMeshArray[i]);
 	}
 
-
-	// Find/Init missile target
-	GameObj* missileTarget = nullptr;
-	for (int i = 0; i < GAME_OBJ_INST_MAX; i++) {
-		GameObj* pInst = sGameObjInstArray + i;
-
-		// skip inactive object
-		if (pInst->flag == FLAG_INACTIVE)
-			continue;
-
-		if (pInst->type == TYPE_ASTEROID) {
-			missileTarget = pInst;
-			break;
-		}
+	//+ Unload all textures in TexArray
+	for (int i = 0; i < sNumTex; i++) {
+		TextureUnload(sTexArray[i]);
 	}
 
-	//---------------------------------------------------------
-	// Update all game obj position using velocity 
-	//---------------------------------------------------------
-
+	//+ give the game object chunks back
+	GameObjShutdown();
 
-	for (int i = 0; i < GAME_OBJ_INST_MAX; i++) {
-		GameObj* pInst = sGameObjInstArray + i;
+	TaskGraphDestroy(sUpdateGraph);
+	TaskGraphDestroy(sDrawGraph);
+	sUpdateGraph = NULL;
+	sDrawGraph = NULL;
 
-		// skip inactive object
-		if (pInst->flag == FLAG_INACTIVE)
-			continue;
+	SpatialGridDestroy(sAsteroidGrid);
+	SpatialGridDestroy(sCollisionGrid);
+	SweepPruneDestroy(sSweepPrune);
+	AabbTreeDestroy(sCollisionTree);
+	sAsteroidGrid = NULL;
+	sCollisionGrid = NULL;
+	sSweepPrune = NULL;
+	sCollisionTree = NULL;
+	AISchedulerRemoveAll();
 
-		if (pInst->type == TYPE_SHIP) {
-			//+ for ship: add some friction to slow it down
-			float friction = 0.005f;
-			pInst->velocity *= (1.0f - friction);
+	printf("Level1: Unload\n");
+}
 
-			//+ use velocity to update the position
-			pInst->position += pInst->velocity * (float)dt;
-		}
-		else if ((pInst->type == TYPE_BULLET) || (pInst->type == TYPE_ASTEROID)) {
 
-			//+ use velocity to update the position
-			pInst->position += pInst->velocity * (float)dt;
-		}
-		else  if (pInst->type == TYPE_MISSILE) {
+// -------------------------------------------
+// Benchmark, run with --bench (no window needed)
+// -------------------------------------------
 
-			if (missileTarget != nullptr) {
-				// Calculate the direction vector from the object's position to the target point
-				glm::vec3 direction = glm::normalize(missileTarget->position - pInst->position);
+#define BENCH_HALF_WIDTH		512				// The screen of the measures, 1024x768
+#define BENCH_HALF_HEIGHT		384
+#define BENCH_DT				(1.0f / 60.0f)
+#define BENCH_PAIR_RUN			20				// Updates per broadphase measure
 
-				// Calculate the angle between the direction vector and the positive x-axis
-				float angle = atan2(direction.y, direction.x) - PI / 2.0f;
+// Same work as updatePass(), one loop per step, each loop loads the objects again
+static void updateMultiPass(int type, float dt, int halfWidth, int halfHeight) {
+	for (int c = 0; c < GameObjNumChunk(type); c++) {
+		const GameObjArrays& obj = GameObjChunkData(type, c);
+		int count = GameObjChunkCount(type, c);
 
-				float max_rotate = HOMING_MISSILE_ROT_SPEED * dt;
-				if (abs(angle - pInst->orientation) > max_rotate) {
+		for (int i = 0; i < count; i++) {
+			obj.prevPosition[i] = obj.position[i];
+			obj.position[i] += obj.velocity[i] * dt;
+		}
+	}
 
-					if (angle > pInst->orientation) {
-						pInst->orientation += max_rotate;
-					}
-					else {
-						pInst->orientation -= max_rotate;
-					}
-				}
-				else {
-					pInst->orientation = angle;
-				}
+	for (int c = 0; c < GameObjNumChunk(type); c++) {
+		const GameObjArrays& obj = GameObjChunkData(type, c);
+		int count = GameObjChunkCount(type, c);
 
-				glm::vec3 bullet_velocity = glm::vec3(BULLET_SPEED * glm::cos(pInst->orientation + PI / 2.0f),
-					BULLET_SPEED * glm::sin(pInst->orientation + PI / 2.0f), 0);
+		for (int i = 0; i < count; i++) {
+			int distance_x = abs(obj.position[i].x);
+			int distance_y = abs(obj.position[i].y);
 
-				pInst->velocity = bullet_velocity;
+			if (distance_x > halfWidth) {
+				obj.position[i].x *= -1;
+				obj.prevPosition[i].x = obj.position[i].x;
 			}
 
-			//+ use velocity to update the position
-			pInst->position += pInst->velocity * (float)dt;
+			if (distance_y > halfHeight) {
+				obj.position[i].y *= -1;
+				obj.prevPosition[i].y = obj.position[i].y;
+			}
 		}
 	}
 
+	for (int c = 0; c < GameObjNumChunk(type); c++) {
+		const GameObjArrays& obj = GameObjChunkData(type, c);
+		int count = GameObjChunkCount(type, c);
 
-	//-----------------------------------------
-	// Update some game obj behavior
-	//	- wrap ship around the screen
-	//	- destroy bullet that go out of the screen
-	//-----------------------------------------
+		for (int i = 0; i < count; i++) {
+			obj.modelMatrix[i] = GameObjModelMatrix(obj.position[i], obj.scale[i], obj.direction[i]);
+		}
+	}
+}
 
-	for (int i = 0; i < GAME_OBJ_INST_MAX; i++) {
-		GameObj* pInst = sGameObjInstArray + i;
+// Missile steering with the orientation as an angle, as it was before the direction vectors
+//	- atan2 toward the target, cos/sin for the velocity and again for the modelMatrix
+//	- fast = the approximations of gtx/fast_trigonometry instead of the libm functions
+static void steerAngle(int count, const glm::vec2* pos, const glm::vec2* target, float* angle,
+	glm::vec2* vel, glm::mat4* matrix, float maxRotate, bool fast) {
+	for (int i = 0; i < count; i++) {
+		glm::vec2 d = glm::normalize(target[i] - pos[i]);
+		float want = (fast ? glm::fastAtan(d.y, d.x) : atan2f(d.y, d.x)) - PI / 2.0f;
+
+		if (abs(want - angle[i]) > maxRotate)
+			angle[i] += (want > angle[i]) ? maxRotate : -maxRotate;
+		else
+			angle[i] = want;
+
+		float c = fast ? glm::fastCos(angle[i] + PI / 2.0f) : glm::cos(angle[i] + PI / 2.0f);
+		float s = fast ? glm::fastSin(angle[i] + PI / 2.0f) : glm::sin(angle[i] + PI / 2.0f);
+		vel[i] = BULLET_SPEED * glm::vec2(c, s);
+
+		// the rotation of the matrix, cos/sin of the angle itself
+		glm::vec2 dir(-(fast ? glm::fastSin(angle[i]) : glm::sin(angle[i])), fast ? glm::fastCos(angle[i]) : glm::cos(angle[i]));
+		matrix[i] = GameObjModelMatrix(pos[i], glm::vec2(25.0f), dir);
+	}
+}
 
-		// skip inactive object
-		if (pInst->flag == FLAG_INACTIVE)
-			continue;
+// The same with the direction vector, what phaseSteer() and updatePass() do
+static void steerDirection(int count, const glm::vec2* pos, const glm::vec2* target, glm::vec2* dir,
+	glm::vec2* vel, glm::mat4* matrix, glm::vec2 rot) {
+	for (int i = 0; i < count; i++) {
+		glm::vec2 toTarget = target[i] - pos[i];
+		dir[i] = turnToward(dir[i], toTarget * glm::inversesqrt(glm::dot(toTarget, toTarget)), rot);
+		vel[i] = BULLET_SPEED * dir[i];
+		matrix[i] = GameObjModelMatrix(pos[i], glm::vec2(25.0f), dir[i]);
+	}
+}
 
-		int distance_x = abs(pInst->position.x);
-		int distance_y = abs(pInst->position.y);
+// Spawn, destroy and flush in the pool, grow it to GAME_OBJ_CHUNK_MAX chunks and compact it again
+static void benchPool() {
 
-		if ((pInst->type == TYPE_SHIP) || (pInst->type == TYPE_ASTEROID)) {
-			//+ wrap the ship and asteroid around the screen 
-			if (distance_x > GetWindowWidth() / 2) {
-				pInst->position.x *= -1;
-			}
+	const int	numSpawn = 1000000;
+	const int	capacity = 16 * GAME_OBJ_CHUNK_SIZE;
+	const int	occupancy[3] = { 10, 50, 99 };		// in percent of capacity
 
-			if (distance_y > GetWindowHeight() / 2) {
-				pInst->position.y *= -1;
-			}
-		}
-		else if (pInst->type == TYPE_BULLET || pInst->type == TYPE_MISSILE) {
+	printf("Level1: GameObjCreate/GameObjDestroy/GameObjFlush, %d spawns per run\n", numSpawn);
 
-			//+ call gameObjInstDestroy() on bullet that go out of the screen X [-width/2,width/2], Y [-height/2,height/2]
-			if (distance_x > GetWindowWidth() / 2 || distance_y > GetWindowHeight() / 2) {
-				gameObjInstDestroy(*pInst);
-			}
+	for (int k = 0; k < 3; k++) {
 
+		// fill the pool up to the wanted occupancy
+		GameObjReset();
+		int numFill = capacity * occupancy[k] / 100;
+		for (int i = 0; i < numFill; i++) {
+			GameObjCreate(TYPE_ASTEROID, glm::vec2(0.0f), glm::vec2(0.0f), glm::vec2(1.0f), glm::vec2(0.0f, 1.0f));
 		}
-	}
-
-	//-----------------------------------------
-	// Check for collsion, O(n^2)
-	//-----------------------------------------
 
-	for (int i = 0; i < GAME_OBJ_INST_MAX; i++) {
-		GameObj* pInst1 = sGameObjInstArray + i;
-
-		// skip inactive object
-		if (pInst1->flag == FLAG_INACTIVE)
-			continue;
+		// spawn and kill a bullet, so the occupancy stays the same for every spawn
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < numSpawn; i++) {
+			GameObjDestroy(GameObjCreate(TYPE_BULLET, glm::vec2(0.0f), glm::vec2(0.0f), glm::vec2(1.0f), glm::vec2(0.0f, 1.0f)));
+			GameObjFlush(false);
+		}
+		auto stop = std::chrono::high_resolution_clock::now();
 
-		// if pInst1 is an asteroid
-		if (pInst1->type == TYPE_ASTEROID) {
+		double ns = std::chrono::duration<double, std::nano>(stop - start).count() / numSpawn;
+		printf("  occupancy %3d%% (%6d/%d): %6.2f ns per spawn+destroy+flush\n", occupancy[k], GameObjCount(TYPE_ASTEROID) + GameObjCount(TYPE_BULLET), capacity, ns);
+	}
 
-			// compare pInst1 with all game obj instances 
-			for (int j = 0; j < GAME_OBJ_INST_MAX; j++) {
-				GameObj* pInst2 = sGameObjInstArray + j;
+	// spawn an asteroid field, one create per object vs one batch
+	const int	numField = 100000;
+	std::vector<glm::vec2> position(numField, glm::vec2(0.0f));
+	std::vector<glm::vec2> velocity(numField, glm::vec2(0.0f));
+	for (int k = 0; k < 2; k++) {
+		GameObjShutdown();
+		auto start = std::chrono::high_resolution_clock::now();
+		if (k == 0) {
+			for (int i = 0; i < numField; i++) {
+				GameObjCreate(TYPE_ASTEROID, position[i], velocity[i], glm::vec2(50.0f), glm::vec2(0.0f, 1.0f));
+			}
+		}
+		else {
+			GameObjCreateBatch(TYPE_ASTEROID, numField, position.data(), velocity.data(), glm::vec2(50.0f), glm::vec2(0.0f, 1.0f), NULL);
+		}
+		auto stop = std::chrono::high_resolution_clock::now();
 
-				// skip inactive object
-				if (pInst2->flag == FLAG_INACTIVE)
-					continue;
+		double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+		printf("  %s %d asteroids: %.2f ms, %.2f ns per spawn\n", k == 0 ? "create" : "batch ", GameObjCount(TYPE_ASTEROID),
+			ms, ms * 1.0e6 / numField);
+	}
 
-				// skip asteroid object
-				if (pInst2->type == TYPE_ASTEROID)
-					continue;
+	// grow from nothing to the full 1M instances, one chunk at a time
+	GameObjShutdown();
+	int numMax = GAME_OBJ_CHUNK_MAX * GAME_OBJ_CHUNK_SIZE;
+	std::vector<GameObjHandle> handles(numMax);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < numMax; i++) {
+		handles[i] = GameObjCreate(TYPE_ASTEROID, glm::vec2(0.0f), glm::vec2(0.0f), glm::vec2(1.0f), glm::vec2(0.0f, 1.0f));
+	}
+	auto stop = std::chrono::high_resolution_clock::now();
 
-				if (pInst2->type == TYPE_SHIP) {
+	double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+	printf("  grow to %d: %.1f ms, %.2f ns per spawn, create when full returns %u\n", numMax, ms, ms * 1.0e6 / numMax,
+		GameObjCreate(TYPE_ASTEROID, glm::vec2(0.0f), glm::vec2(0.0f), glm::vec2(1.0f), glm::vec2(0.0f, 1.0f)));
+	GameObjReport(false);
 
-					//+ Check for collsion
-					bool collide = checkCollision(*pInst1, *pInst2);
+	// destroy half of the objects in one batch, then compact to give the empty chunks back
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < numMax / 2; i++) {
+		GameObjDestroy(handles[i * 2]);
+	}
+	GameObjFlush(true);
+	stop = std::chrono::high_resolution_clock::now();
+
+	ms = std::chrono::duration<double, std::milli>(stop - start).count();
+	printf("  destroy %d in one flush: %.1f ms, %.2f ns per object\n", numMax / 2, ms, ms * 1.0e6 / (numMax / 2));
+	GameObjReport(true);
+
+	// the objects were moved around by the flush, the handles still find them
+	start = std::chrono::high_resolution_clock::now();
+	int numValid = 0;
+	for (int i = 0; i < numMax; i++) {
+		numValid += GameObjIsValid(handles[i]);
+	}
+	stop = std::chrono::high_resolution_clock::now();
 
-					if (collide) {
+	ms = std::chrono::duration<double, std::milli>(stop - start).count();
+	printf("  validate %d handles: %d valid, %.2f ns per handle\n", numMax, numValid, ms * 1.0e6 / numMax);
+}
 
-						//+ Update game behavior and sGameObjInstArray
-						gameObjInstDestroy(*pInst1);
+// The asteroid field generated with rand() vs GameRandom, then the update passes on one thread and on all the cores
+static void benchUpdate(GameRandom& rng) {
+
+	const int	numMax = GAME_OBJ_CHUNK_MAX * GAME_OBJ_CHUNK_SIZE;
+	const int	numEntity[3] = { 1000, 100000, numMax };
+	const int	halfWidth = BENCH_HALF_WIDTH, halfHeight = BENCH_HALF_HEIGHT;
+	const float	dt = BENCH_DT;
+
+	const char*	name[4] = { "multi-pass", "fused", "integrate scalar", "integrate" };
+
+	// generate the positions/velocities of 1M asteroids, libc rand() vs GameRandom
+	std::vector<glm::vec2> field(numMax * 2);
+	for (int m = 0; m < 2; m++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < numMax * 2; i++) {
+			if (m == 0)
+				field[i] = glm::vec2(rand() % (halfWidth * 2) - halfWidth, rand() % (halfHeight * 2) - halfHeight);
+			else
+				field[i] = glm::vec2(GameRandomInt(rng, halfWidth * 2) - halfWidth, GameRandomInt(rng, halfHeight * 2) - halfHeight);
+		}
+		auto stop = std::chrono::high_resolution_clock::now();
 
-						if (--sPlayerLives <= 0) {
-							restart();
-						}
+		double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+		printf("Level1: %d asteroids generated with %s: %.1f ms\n", numMax, m == 0 ? "rand()" : "GameRandom", ms);
+	}
 
-						break;
+	// integrate + wrap + modelMatrix, fused vs one pass per step, then the integrate + wrap kernel alone
+	//	- asteroids only, they wrap so the count stays the same
+	//	- about 10M object updates per measure
+	printf("Level1: update passes, integrate + wrap + modelMatrix, %s kernel\n", GameObjKernelName());
+	for (int k = 0; k < 3; k++) {
+		GameObjShutdown();
+
+		std::vector<glm::vec2> position(numEntity[k]);
+		std::vector<glm::vec2> velocity(numEntity[k]);
+		for (int i = 0; i < numEntity[k]; i++) {
+			position[i] = glm::vec2(GameRandomInt(rng, halfWidth * 2) - halfWidth, GameRandomInt(rng, halfHeight * 2) - halfHeight);
+			velocity[i] = glm::vec2(GameRandomInt(rng, (int)(ASTEROID_SPEED * 2)) - ASTEROID_SPEED, GameRandomInt(rng, (int)(ASTEROID_SPEED * 2)) - ASTEROID_SPEED);
+		}
+		GameObjCreateBatch(TYPE_ASTEROID, numEntity[k], position.data(), velocity.data(), glm::vec2(50.0f), glm::vec2(0.0f, 1.0f), NULL);
+
+		int numRun = 10000000 / numEntity[k];
+		if (numRun < 1)
+			numRun = 1;
+
+		printf("  %7d entities:", numEntity[k]);
+		for (int m = 0; m < 4; m++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int r = 0; r < numRun; r++) {
+				if (m == 0) {
+					updateMultiPass(TYPE_ASTEROID, dt, halfWidth, halfHeight);
+				}
+				else if (m == 1) {
+					updatePass(TYPE_ASTEROID, dt, halfWidth, halfHeight);
+				}
+				else {
+					for (int c = 0; c < GameObjNumChunk(TYPE_ASTEROID); c++) {
+						if (m == 2)
+							GameObjIntegrateScalar(GameObjChunkData(TYPE_ASTEROID, c), 0, GameObjChunkCount(TYPE_ASTEROID, c), dt, halfWidth, halfHeight, true);
+						else
+							GameObjIntegrate(GameObjChunkData(TYPE_ASTEROID, c), 0, GameObjChunkCount(TYPE_ASTEROID, c), dt, halfWidth, halfHeight, true);
 					}
 				}
-				else if (pInst2->type == TYPE_BULLET) {
+			}
+			auto stop = std::chrono::high_resolution_clock::now();
+			double ns = std::chrono::duration<double, std::nano>(stop - start).count() / ((double)numRun * numEntity[k]);
+			printf(" %s %.2f ns%s", name[m], ns, m < 3 ? "," : " per entity\n");
+		}
+	}
 
-					//+ Check for collsion
-					bool collide = checkCollision(*pInst1, *pInst2);
+	// the same fused pass over 1M asteroids, spread over more and more threads
+	int numCore = glm::max((int)std::thread::hardware_concurrency(), 1);
+	double nsOne = 0.0;
 
-					if (collide) {
+	printf("Level1: fused update pass over %d entities, %d cores\n", numMax, numCore);
+	for (int numThread = 1; ; numThread = glm::min(numThread * 2, numCore)) {
+		JobSystemInit(numThread);
 
-						//+ Update game behavior and sGameObjInstArray
-						gameObjInstDestroy(*pInst1);
-						gameObjInstDestroy(*pInst2);
+		int numRun = 20;
+		updatePass(TYPE_ASTEROID, dt, halfWidth, halfHeight);
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < numRun; r++) {
+			updatePass(TYPE_ASTEROID, dt, halfWidth, halfHeight);
+		}
+		auto stop = std::chrono::high_resolution_clock::now();
 
-						break;
-					}
-				}
-				else if (pInst2->type == TYPE_MISSILE) {
-					//+ Check for collsion
-					bool collide = checkCollision(*pInst1, *pInst2);
+		double ns = std::chrono::duration<double, std::nano>(stop - start).count() / ((double)numRun * numMax);
+		if (numThread == 1)
+			nsOne = ns;
+		printf("  %2d threads: %.2f ns per entity, %.2fx\n", numThread, ns, nsOne / ns);
 
-					if (collide) {
+		if (numThread == numCore)
+			break;
+	}
+	JobSystemShutdown();
+}
 
-						//+ Update game behavior and sGameObjInstArray
-						gameObjInstDestroy(*pInst1);
-						gameObjInstDestroy(*pInst2);
+// Closest asteroid of every missile, linear scan vs the grid
+//	- same asteroids and missiles for both, the targets must be the same
+//	- the asteroids stay in the pool for benchAIBudget()
+static void benchTargets(GameRandom& rng) {
+	const int	numTargetAsteroid = 100000;
+	const int	numTargetMissile = 2000;
+	const int	halfWidth = BENCH_HALF_WIDTH, halfHeight = BENCH_HALF_HEIGHT;
 
-						break;
-					}
+	GameObjShutdown();
+	{
+		std::vector<glm::vec2> position(numTargetAsteroid);
+		std::vector<glm::vec2> velocity(numTargetAsteroid, glm::vec2(0.0f));
+		for (int i = 0; i < numTargetAsteroid; i++) {
+			position[i] = glm::vec2(GameRandomInt(rng, halfWidth * 2) - halfWidth, GameRandomInt(rng, halfHeight * 2) - halfHeight);
+		}
+		GameObjCreateBatch(TYPE_ASTEROID, numTargetAsteroid, position.data(), velocity.data(), glm::vec2(50.0f), glm::vec2(0.0f, 1.0f), NULL);
+	}
+	std::vector<glm::vec2> missile(numTargetMissile);
+	for (int i = 0; i < numTargetMissile; i++) {
+		missile[i] = glm::vec2(GameRandomRange(rng, -halfWidth, halfWidth), GameRandomRange(rng, -halfHeight, halfHeight));
+	}
 
+	std::vector<GameObjHandle> linearTarget(numTargetMissile);
+	auto linearStart = std::chrono::high_resolution_clock::now();
+	for (int m = 0; m < numTargetMissile; m++) {
+		float best = FLT_MAX;
+		for (int c = 0; c < GameObjNumChunk(TYPE_ASTEROID); c++) {
+			const GameObjArrays& obj = GameObjChunkData(TYPE_ASTEROID, c);
+			for (int i = 0; i < GameObjChunkCount(TYPE_ASTEROID, c); i++) {
+				glm::vec2 d = obj.position[i] - missile[m];
+				if (glm::dot(d, d) < best) {
+					best = glm::dot(d, d);
+					linearTarget[m] = obj.handle[i];
 				}
 			}
 		}
 	}
+	auto linearStop = std::chrono::high_resolution_clock::now();
+
+	SpatialGrid* pGrid = SpatialGridCreate();
+	int numRun = 20;
+	int numSame = 0;
+	auto gridStart = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < numRun; r++) {
+		SpatialGridBuild(pGrid, TYPE_ASTEROID, glm::vec2(-halfWidth, -halfHeight), glm::vec2(halfWidth, halfHeight), SPATIAL_GRID_CELL_AUTO);
+	}
+	auto gridBuilt = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < numRun; r++) {
+		for (int m = 0; m < numTargetMissile; m++) {
+			SpatialGridHit hit;
+			if (SpatialGridNearest(pGrid, missile[m], FLT_MAX, 1, &hit) == 1 && r == 0 && hit.handle == linearTarget[m])
+				numSame++;
+		}
+	}
+	auto gridStop = std::chrono::high_resolution_clock::now();
+	SpatialGridDestroy(pGrid);
+
+	double linearMs = std::chrono::duration<double, std::milli>(linearStop - linearStart).count();
+	double buildMs = std::chrono::duration<double, std::milli>(gridBuilt - gridStart).count() / numRun;
+	double queryMs = std::chrono::duration<double, std::milli>(gridStop - gridBuilt).count() / numRun;
+	printf("Level1: closest of %d asteroids for %d missiles\n", numTargetAsteroid, numTargetMissile);
+	printf("  linear scan %.2f ms, grid build %.3f ms + queries %.3f ms (%.1f ns per query), %.0fx, %d/%d same targets\n",
+		linearMs, buildMs, queryMs, queryMs * 1.0e6 / numTargetMissile, linearMs / (buildMs + queryMs), numSame, numTargetMissile);
+}
 
+// Missile steering + velocity + modelMatrix, orientation as an angle (libm, fast trig) vs a direction vector
+//	- every missile after its own target, the targets move a bit every run so the missiles keep turning
+static void benchSteer(GameRandom& rng) {
+	const int	numSteer = 100000;
+	const float	maxRotate = HOMING_MISSILE_ROT_SPEED * BENCH_DT;
+	const int	halfWidth = BENCH_HALF_WIDTH, halfHeight = BENCH_HALF_HEIGHT;
+
+	std::vector<glm::vec2>	steerPos(numSteer), steerTarget(numSteer), steerVel(numSteer), steerDir(numSteer);
+	std::vector<float>		steerAngleArray(numSteer);
+	std::vector<glm::mat4>	steerMatrix(numSteer);
+	for (int i = 0; i < numSteer; i++) {
+		steerPos[i] = glm::vec2(GameRandomRange(rng, -halfWidth, halfWidth), GameRandomRange(rng, -halfHeight, halfHeight));
+		steerTarget[i] = glm::vec2(GameRandomRange(rng, -halfWidth, halfWidth), GameRandomRange(rng, -halfHeight, halfHeight));
+	}
 
-	//-----------------------------------------
-	// Update modelMatrix of all game obj
-	//-----------------------------------------
+	const char*	steerName[3] = { "angle", "angle fast trig", "direction" };
+	double		steerNs[3];
+	glm::vec2	steerRot(glm::cos(maxRotate), glm::sin(maxRotate));
+	for (int m = 0; m < 3; m++) {
+		for (int i = 0; i < numSteer; i++) {
+			steerAngleArray[i] = 0.0f;
+			steerDir[i] = glm::vec2(0.0f, 1.0f);
+		}
 
-	for (int i = 0; i < GAME_OBJ_INST_MAX; i++) {
-		GameObj* pInst = sGameObjInstArray + i;
+		int numRun = 50;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < numRun; r++) {
+			steerTarget[r % numSteer] += glm::vec2(1.0f);
+			if (m < 2)
+				steerAngle(numSteer, steerPos.data(), steerTarget.data(), steerAngleArray.data(), steerVel.data(), steerMatrix.data(), maxRotate, m == 1);
+			else
+				steerDirection(numSteer, steerPos.data(), steerTarget.data(), steerDir.data(), steerVel.data(), steerMatrix.data(), steerRot);
+		}
+		auto stop = std::chrono::high_resolution_clock::now();
+		steerNs[m] = std::chrono::duration<double, std::nano>(stop - start).count() / ((double)numRun * numSteer);
+	}
+	printf("Level1: missile steering + velocity + modelMatrix, %d missiles\n ", numSteer);
+	for (int m = 0; m < 3; m++) {
+		printf(" %s %.2f ns (%.2fx)%s", steerName[m], steerNs[m], steerNs[0] / steerNs[m], m < 2 ? "," : " per missile\n");
+	}
+}
 
-		// skip inactive object
-		if (pInst->flag == FLAG_INACTIVE)
-			continue;
+// A spike of missiles, steering time per update with no AI budget and with a budget
+//	- against the asteroids benchTargets() left in the pool
+static void benchAIBudget(GameRandom& rng) {
+	const int	numSpikeMissile = 200000;
+	const int	spikeBudget[2] = { 0, 32768 };
+	const int	halfWidth = BENCH_HALF_WIDTH, halfHeight = BENCH_HALF_HEIGHT;
 
-		glm::mat4 rMat = glm::mat4(1.0f);
-		glm::mat4 sMat = glm::mat4(1.0f);
-		glm::mat4 tMat = glm::mat4(1.0f);
+	{
+		std::vector<glm::vec2> position(numSpikeMissile), velocity(numSpikeMissile, glm::vec2(0.0f));
+		for (int i = 0; i < numSpikeMissile; i++) {
+			position[i] = glm::vec2(GameRandomRange(rng, -halfWidth, halfWidth), GameRandomRange(rng, -halfHeight, halfHeight));
+		}
+		GameObjCreateBatch(TYPE_MISSILE, numSpikeMissile, position.data(), velocity.data(), glm::vec2(25.0f), glm::vec2(0.0f, 1.0f), NULL);
+	}
+	sAsteroidGrid = SpatialGridCreate();
+	SpatialGridBuild(sAsteroidGrid, TYPE_ASTEROID, glm::vec2(-halfWidth, -halfHeight), glm::vec2(halfWidth, halfHeight), SPATIAL_GRID_CELL_AUTO);
+	int steerTask = AISchedulerAdd("missile steering", TYPE_MISSILE, steerMissiles);
+	int budget = AISchedulerGetBudget();
+	sTickDt = BENCH_DT;
+
+	printf("Level1: steering %d missiles against %d asteroids, AI budget per update\n", numSpikeMissile, GameObjCount(TYPE_ASTEROID));
+	for (int k = 0; k < 2; k++) {
+		AISchedulerSetBudget(spikeBudget[k]);
+		AISchedulerReset();
+
+		int numRun = 30;
+		double totalMs = 0.0, maxMs = 0.0;
+		for (int r = 0; r < numRun; r++) {
+			sTickFrame = r;
+			auto start = std::chrono::high_resolution_clock::now();
+			AISchedulerRun();
+			auto stop = std::chrono::high_resolution_clock::now();
+
+			double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+			totalMs += ms;
+			maxMs = glm::max(maxMs, ms);
+		}
+		printf("  budget %5d missiles: %.3f ms per update, max %.3f ms, every missile once in %d updates\n",
+			spikeBudget[k], totalMs / numRun, maxMs, AISchedulerPassLength(steerTask));
+	}
 
-		// Compute the scaling matrix
-		sMat = glm::scale(glm::mat4(1.0f), pInst->scale);
+	AISchedulerSetBudget(budget);
+	AISchedulerRemoveAll();
+	SpatialGridDestroy(sAsteroidGrid);
+	sAsteroidGrid = NULL;
+}
 
-		//+ Compute the rotation matrix, we should rotate around z axis 
-		rMat = glm::rotate(glm::mat4(1.0f), pInst->orientation, glm::vec3(0.0f, 0.0f, 1.0f));
+// Every asteroid against every bullet, loop vs grid vs sweep and prune vs tree
+//	- small asteroids so the pairs stay about as many as in a game, all must find the same pairs in the same order
+//	- the asteroids move at up to ASTEROID_SPEED between the updates, the sweep and prune sorts again from the last order
+//	- the loop takes seconds, it only runs on the last update
+//	- outPairs = the pairs of the loop, the objects stay in the pool for benchNarrowphase() and benchCollisionKernels()
+static void benchBroadphase(GameRandom& rng, std::vector<CollisionPair>& outPairs) {
+	const int	numPairAsteroid = 100000;
+	const int	numPairBullet = 10000;
+	const int	numPairRun = BENCH_PAIR_RUN;
+	const int	halfWidth = BENCH_HALF_WIDTH, halfHeight = BENCH_HALF_HEIGHT;
+	const float	dt = BENCH_DT;
+
+	GameObjShutdown();
+	{
+		std::vector<glm::vec2> position(numPairAsteroid), velocity(numPairAsteroid);
+		for (int i = 0; i < numPairAsteroid; i++) {
+			position[i] = glm::vec2(GameRandomRange(rng, -halfWidth, halfWidth), GameRandomRange(rng, -halfHeight, halfHeight));
+			velocity[i] = glm::vec2(GameRandomRange(rng, -ASTEROID_SPEED, ASTEROID_SPEED), GameRandomRange(rng, -ASTEROID_SPEED, ASTEROID_SPEED));
+		}
+		GameObjCreateBatch(TYPE_ASTEROID, numPairAsteroid, position.data(), velocity.data(), glm::vec2(4.0f), glm::vec2(0.0f, 1.0f), NULL);
+		for (int i = 0; i < numPairBullet; i++) {
+			position[i] = glm::vec2(GameRandomRange(rng, -halfWidth, halfWidth), GameRandomRange(rng, -halfHeight, halfHeight));
+			velocity[i] = glm::vec2(0.0f);
+		}
+		GameObjCreateBatch(TYPE_BULLET, numPairBullet, position.data(), velocity.data(), glm::vec2(1.0f), glm::vec2(0.0f, 1.0f), NULL);
+	}
+	sCollisionGrid = SpatialGridCreate();
+	sSweepPrune = SweepPruneCreate(TYPE_ASTEROID, sTargetType, NUM_TARGET_TYPE);
+	sCollisionTree = AabbTreeCreate(TYPE_ASTEROID, ASTEROID_TREE_MARGIN);
+
+	std::vector<CollisionPair>	modePairs[NUM_BROADPHASE];
+	double						modeMs[NUM_BROADPHASE] = { 0.0 };
+	long						numMove = 0;
+	long						numTreeMove = 0;
+	for (int r = 0; r < numPairRun; r++) {
+		for (int c = 0; c < GameObjNumChunk(TYPE_ASTEROID); c++) {
+			const GameObjArrays& obj = GameObjChunkData(TYPE_ASTEROID, c);
+			for (int i = 0; i < GameObjChunkCount(TYPE_ASTEROID, c); i++) {
+				obj.prevPosition[i] = obj.position[i];
+				obj.position[i] += obj.velocity[i] * dt;
+			}
+		}
+
+		for (int m = 0; m < NUM_BROADPHASE; m++) {
+			if (m == BROADPHASE_LOOP && r < numPairRun - 1)
+				continue;
 
-		//+ Compute the translation matrix
-		tMat = glm::translate(glm::mat4(1.0f), pInst->position);
+			modePairs[m].clear();
+			auto start = std::chrono::high_resolution_clock::now();
+			runBroadphase(m, modePairs[m], halfWidth, halfHeight);
+			auto stop = std::chrono::high_resolution_clock::now();
 
-		// Concatenate the 3 matrix to from Model Matrix
-		pInst->modelMatrix = tMat * sMat * rMat;
+			// the first update fills the sweep and prune and the tree from scratch, it is not counted
+			if (r > 0 || m == BROADPHASE_LOOP)
+				modeMs[m] += std::chrono::duration<double, std::milli>(stop - start).count();
+		}
+		if (r > 0) {
+			numMove += SweepPruneNumMove(sSweepPrune);
+			numTreeMove += AabbTreeNumMove(sCollisionTree);
+		}
 	}
+	int treeHeight = AabbTreeHeight(sCollisionTree);
+	SpatialGridDestroy(sCollisionGrid);
+	SweepPruneDestroy(sSweepPrune);
+	AabbTreeDestroy(sCollisionTree);
+	sCollisionGrid = NULL;
+	sSweepPrune = NULL;
+	sCollisionTree = NULL;
+
+	const std::vector<CollisionPair>& loopPairs = modePairs[BROADPHASE_LOOP];
+	outPairs = loopPairs;
+	printf("Level1: broadphase, %d moving asteroids against %d bullets, %d pairs\n", numPairAsteroid, numPairBullet, (int)loopPairs.size());
+	for (int m = 0; m < NUM_BROADPHASE; m++) {
+		bool samePairs = loopPairs.size() == modePairs[m].size();
+		for (size_t n = 0; samePairs && n < loopPairs.size(); n++) {
+			samePairs = loopPairs[n].obj1 == modePairs[m][n].obj1 && loopPairs[n].obj2 == modePairs[m][n].obj2 &&
+				loopPairs[n].hit == modePairs[m][n].hit;
+		}
 
-	//printf("Life> %i\n", sPlayerLives);
-	//printf("Score> %i\n", sScore);
+		double ms = (m == BROADPHASE_LOOP) ? modeMs[m] : modeMs[m] / (numPairRun - 1);
+		printf("  %-4s %9.3f ms per update, %6.0fx, %s\n", sBroadphaseName[m], ms, modeMs[BROADPHASE_LOOP] / ms,
+			samePairs ? "same pairs" : "PAIRS DIFFER");
+	}
+	printf("  sap insertion sort: %.2f moves per object per update\n",
+		(double)numMove / ((numPairRun - 1) * (double)(numPairAsteroid + numPairBullet)));
+	printf("  tree: %.2f%% of the asteroids reinserted per update, height %d\n",
+		100.0 * numTreeMove / ((numPairRun - 1) * (double)numPairAsteroid), treeHeight);
 }
 
-void GameStateLevel1Draw(void) {
+// Narrow phase on the pairs of benchBroadphase(), the old box test vs the shapes
+//	- the shapes are smaller than the old boxes, they hit less
+static void benchNarrowphase(const std::vector<CollisionPair>& loopPairs) {
+	int		numHit[2] = { 0, 0 };
+	double	narrowNs[2];
+	for (int m = 0; m < 2; m++) {
+		int numNarrowRun = 20;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < numNarrowRun; r++) {
+			numHit[m] = 0;
+			for (size_t n = 0; n < loopPairs.size(); n++) {
+				int i, j;
+				const GameObjArrays& obj1 = GameObjFind(loopPairs[n].obj1, i);
+				const GameObjArrays& obj2 = GameObjFind(loopPairs[n].obj2, j);
+				if (m == 0)
+					numHit[m] += checkCollisionBox(obj1.position[i], obj1.scale[i], obj2.position[j]);
+				else
+					numHit[m] += checkCollision(obj1.position[i], sShape[TYPE_ASTEROID].radius * obj1.scale[i].x, obj2, j, loopPairs[n].type2);
+			}
+		}
+		auto stop = std::chrono::high_resolution_clock::now();
+		narrowNs[m] = std::chrono::duration<double, std::nano>(stop - start).count() / ((double)numNarrowRun * loopPairs.size());
+	}
+	printf("Level1: narrow phase, %d pairs\n", (int)loopPairs.size());
+	printf("  box %.2f ns per pair, %d hits, shapes %.2f ns per pair, %d hits, %.2fx\n",
+		narrowNs[0], numHit[0], narrowNs[1], numHit[1], narrowNs[0] / narrowNs[1]);
+}
 
-	// Clear the screen
-	glClearColor(0.5f, 0.5f, 0.5f, 0.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+static const char*	sBenchKernelName[3] = { "scalar", "AVX2", "AVX-512" };
 
-	// draw all game object instance in the sGameObjInstArray
-	for (int i = 0; i < GAME_OBJ_INST_MAX; i++) {
-		GameObj* pInst = sGameObjInstArray + i;
+// The grid broadphase with each kernel the CPU has, on the objects in the pool
+//	- the candidates of a target are tested in one call, all kernels must find the same hits
+static void benchGridKernels(int numRun) {
+	const char*					bestKernel = CollisionKernelName();
+	std::vector<CollisionPair>	refPairs, kernelPairs;
+	double						scalarMs = 0.0;
 
-		// skip inactive object
-		if (pInst->flag == FLAG_INACTIVE)
+	sCollisionGrid = SpatialGridCreate();
+	for (int m = 0; m < 3; m++) {
+		if (!CollisionKernelSelect(sBenchKernelName[m]))
 			continue;
 
-		// 4 steps to draw sprites on the screen
-		//	1. SetRenderMode()
-		//	2. SetTexture()
-		//	3. SetTransform()
-		//	4. DrawMesh()
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < numRun; r++) {
+			kernelPairs.clear();
+			runBroadphase(BROADPHASE_GRID, kernelPairs, BENCH_HALF_WIDTH, BENCH_HALF_HEIGHT);
+		}
+		auto stop = std::chrono::high_resolution_clock::now();
+		double ms = std::chrono::duration<double, std::milli>(stop - start).count() / numRun;
+		if (m == 0) {
+			scalarMs = ms;
+			refPairs = kernelPairs;
+		}
 
-		SetRenderMode(CDT_TEXTURE, 1.0f);
-		SetTexture(*pInst->tex, 0.0f, 0.0f);
-		SetTransform(pInst->modelMatrix);
-		DrawMesh(*pInst->mesh);
+		bool sameHits = refPairs.size() == kernelPairs.size();
+		for (size_t n = 0; sameHits && n < refPairs.size(); n++) {
+			sameHits = refPairs[n].obj1 == kernelPairs[n].obj1 && refPairs[n].obj2 == kernelPairs[n].obj2 && refPairs[n].hit == kernelPairs[n].hit;
+		}
+		printf("  grid %-7s %8.3f ms per update, %5.2fx, %s\n", sBenchKernelName[m], ms, scalarMs / ms, sameHits ? "same hits" : "HITS DIFFER");
 	}
-
-	// Swap the buffer, to present the drawing
-	glfwSwapBuffers(window);
+	SpatialGridDestroy(sCollisionGrid);
+	sCollisionGrid = NULL;
+	CollisionKernelSelect(bestKernel);
 }
 
-void GameStateLevel1Free(void) {
+// The collision kernels in the grid broadphase, on the objects of benchBroadphase() then on a dense field,
+// then the kernels alone
+static void benchCollisionKernels(GameRandom& rng) {
+	const char*	bestKernel = CollisionKernelName();
 
-	//+ call gameObjInstDestroy for all object instances in the sGameObjInstArray
-	for (int i = 0; i < GAME_OBJ_INST_MAX; i++)
-	{
-		gameObjInstDestroy(sGameObjInstArray[i]);
-	}
+	printf("Level1: collision kernels, %s best\n", bestKernel);
+	benchGridKernels(BENCH_PAIR_RUN);
 
-	// reset camera
-	ResetCam();
+	// the same where every target is in the boxes of many asteroids, large asteroids around bullets and missiles
+	const int	numDenseAsteroid = 20000;
+	const int	numDenseBullet = 1000;
+	const int	numDenseMissile = 200;
+	const int	halfWidth = BENCH_HALF_WIDTH, halfHeight = BENCH_HALF_HEIGHT;
 
-	printf("Level1: Free\n");
+	GameObjShutdown();
+	{
+		std::vector<glm::vec2> position(numDenseAsteroid), velocity(numDenseAsteroid, glm::vec2(0.0f));
+		for (int i = 0; i < numDenseAsteroid; i++) {
+			position[i] = glm::vec2(GameRandomRange(rng, -halfWidth, halfWidth), GameRandomRange(rng, -halfHeight, halfHeight));
+		}
+		GameObjCreateBatch(TYPE_ASTEROID, numDenseAsteroid, position.data(), velocity.data(), glm::vec2(40.0f), glm::vec2(0.0f, 1.0f), NULL);
+		for (int i = 0; i < numDenseBullet; i++) {
+			position[i] = glm::vec2(GameRandomRange(rng, -halfWidth, halfWidth), GameRandomRange(rng, -halfHeight, halfHeight));
+		}
+		GameObjCreateBatch(TYPE_BULLET, numDenseBullet, position.data(), velocity.data(), glm::vec2(1.0f), glm::vec2(0.0f, 1.0f), NULL);
+		for (int i = 0; i < numDenseMissile; i++) {
+			position[i] = glm::vec2(GameRandomRange(rng, -halfWidth, halfWidth), GameRandomRange(rng, -halfHeight, halfHeight));
+		}
+		GameObjCreateBatch(TYPE_MISSILE, numDenseMissile, position.data(), velocity.data(), glm::vec2(25.0f), glm::vec2(0.6f, 0.8f), NULL);
+	}
+	printf("  %d large asteroids against %d bullets and %d missiles\n", numDenseAsteroid, numDenseBullet, numDenseMissile);
+	benchGridKernels(BENCH_PAIR_RUN);
+
+	// the kernels alone, one bullet and one missile against numCircle asteroids
+	const int	numCircle = 4096;
+	const int	numCircleRun = 2000;
+	std::vector<float>		circleX(numCircle), circleY(numCircle), circleRadius(numCircle);
+	std::vector<uint32_t>	refMask((numCircle + 31) / 32), mask((numCircle + 31) / 32);
+	for (int n = 0; n < numCircle; n++) {
+		circleX[n] = GameRandomRange(rng, -100.0f, 100.0f);
+		circleY[n] = GameRandomRange(rng, -100.0f, 100.0f);
+		circleRadius[n] = GameRandomRange(rng, 10.0f, 40.0f);
+	}
+	glm::vec2	missileDir = glm::normalize(glm::vec2(0.6f, 0.8f));
+	printf("  one against %d circles, the kernels alone\n", numCircle);
+	for (int shape = 0; shape < 2; shape++) {
+		if (shape == 0)
+			CollisionPointCirclesScalar(glm::vec2(3.0f, -7.0f), circleX.data(), circleY.data(), circleRadius.data(), numCircle, refMask.data());
+		else
+			CollisionCapsuleCirclesScalar(glm::vec2(3.0f, -7.0f), missileDir, 10.0f, 0.0f, circleX.data(), circleY.data(), circleRadius.data(), numCircle, refMask.data());
+
+		double scalarNs = 0.0;
+		for (int m = 0; m < 3; m++) {
+			if (!CollisionKernelSelect(sBenchKernelName[m]))
+				continue;
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int r = 0; r < numCircleRun; r++) {
+				glm::vec2 p(3.0f, -7.0f + r * 0.001f);
+				if (shape == 0)
+					CollisionPointCircles(p, circleX.data(), circleY.data(), circleRadius.data(), numCircle, mask.data());
+				else
+					CollisionCapsuleCircles(p, missileDir, 10.0f, 0.0f, circleX.data(), circleY.data(), circleRadius.data(), numCircle, mask.data());
+			}
+			auto stop = std::chrono::high_resolution_clock::now();
+			double ns = std::chrono::duration<double, std::nano>(stop - start).count() / ((double)numCircleRun * numCircle);
+			if (m == 0)
+				scalarNs = ns;
+
+			// the runs move p, run once more at the reference position
+			if (shape == 0)
+				CollisionPointCircles(glm::vec2(3.0f, -7.0f), circleX.data(), circleY.data(), circleRadius.data(), numCircle, mask.data());
+			else
+				CollisionCapsuleCircles(glm::vec2(3.0f, -7.0f), missileDir, 10.0f, 0.0f, circleX.data(), circleY.data(), circleRadius.data(), numCircle, mask.data());
+			printf("  %-7s %-7s %.3f ns per circle, %5.2fx, %s\n", shape == 0 ? "point" : "segment", sBenchKernelName[m], ns, scalarNs / ns,
+				mask == refMask ? "same mask" : "MASK DIFFERS");
+		}
+	}
+	CollisionKernelSelect(bestKernel);
 }
 
-void GameStateLevel1Unload(void) {
+void GameStateLevel1Benchmark(void) {
 
-	// Unload all meshes in MeshArray
-	for (int i = 0; i < sNumMesh; i++) {
-		UnloadMesh(sMeshArray[i]);
-	}
+	// same layout in every run
+	GameRandom rng;
+	GameRandomSeed(rng, 1);
 
-	//+ Unload all textures in TexArray
-	for (int i = 0; i < sNumTex; i++) {
-		TextureUnload(sTexArray[i]);
-	}
+	benchPool();
+	benchUpdate(rng);
+	benchTargets(rng);
+	benchSteer(rng);
+	benchAIBudget(rng);
 
+	std::vector<CollisionPair> pairs;
+	benchBroadphase(rng, pairs);
+	benchNarrowphase(pairs);
+	benchCollisionKernels(rng);
 
-	printf("Level1: Unload\n");
+	GameObjShutdown();
 }
@@ -20,13 +20,19 @@ extern GLFWwindow* window;
 
 // ---------------------------------------------------------------------------
 
+void GameStateLevel1SetNumAsteroid(int num);		// Before Init, the number of asteroids spawned (stress runs)
+int  GameStateLevel1GetNumAsteroid(void);
+bool GameStateLevel1SetBroadphase(const char* name);	// "loop", "grid", "sap", "tree", false when unknown, by the asteroid count when not set
 void GameStateLevel1Load(void);
 void GameStateLevel1Init(void);
 void GameStateLevel1Update(double dt, long frame, int &state);
-void GameStateLevel1Draw(void);
+void GameStateLevel1Draw(double alpha);		// alpha in [0, 1), how far the frame is between the last two updates
 void GameStateLevel1Free(void);
 void GameStateLevel1Unload(void);
 
+// Measure the game object pool, does not need a window/GL context
+void GameStateLevel1Benchmark(void);
+
 // ---------------------------------------------------------------------------
 
 #endif // GAME_STATE_LEVEL1
\ No newline at end of file
@@ -1,6 +1,8 @@
 
 
 #include "GameStateLevel2.h"
+#include "CDT.h"
+#include "system.h"
 
 
 
@@ -24,7 +26,7 @@ void GameStateLevel2Update(double dt, long frame, int &state){
 
 }
 
-void GameStateLevel2Draw(void){
+void GameStateLevel2Draw(double /*alpha*/){
 
 	printf("Level2: Draw\n");
 
@@ -32,14 +34,13 @@ void GameStateLevel2Draw(void){
 	green += 0.01f;
 
 	// Clear the screen
-	glClearColor(0.0f, glm::abs(glm::sin(green)), 0.0f, 0.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	ClearScreen(0.0f, glm::abs(glm::sin(green)), 0.0f);
 
 
 
 	
 
-	glfwSwapBuffers(window);
+	SystemSwapBuffers();
 
 }
 
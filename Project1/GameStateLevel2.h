@@ -21,7 +21,7 @@ extern GLFWwindow* window;
 void GameStateLevel2Load(void);
 void GameStateLevel2Init(void);
 void GameStateLevel2Update(double dt, long frame, int &state);
-void GameStateLevel2Draw(void);
+void GameStateLevel2Draw(double alpha);
 void GameStateLevel2Free(void);
 void GameStateLevel2Unload(void);
 
@@ -0,0 +1,238 @@
+#include "JobSystem.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define JOB_THREAD_MAX		64
+#define JOB_SPIN			1000			// Failed steal rounds before a worker goes to sleep
+
+// -------------------------------------------
+// Job queues
+// -------------------------------------------
+
+struct Job
+{
+	const std::function<void(int, int)>*	func;
+	const std::function<void()>*			task;		// JobRun() job, func is NULL
+	int					begin;
+	int					end;
+	std::atomic<int>*	numLeft;			// Jobs of the same JobParallelFor() still to finish, NULL for JobRun()
+};
+
+struct JobQueue
+{
+	std::mutex			mutex;
+	std::deque<Job>		jobs;
+};
+
+static JobQueue					sQueue[JOB_THREAD_MAX];		// [0] is the main thread
+static std::vector<std::thread>	sWorker;
+static int						sNumThread = 1;
+static std::atomic<int>			sNumPending(0);				// Jobs pushed and not taken yet
+static std::atomic<bool>		sQuit(false);
+static std::mutex				sSleepMutex;
+static std::condition_variable	sSleepCond;
+
+static thread_local int			tThreadIndex = 0;
+
+
+static bool popJob(int index, Job& job)
+{
+	JobQueue& queue = sQueue[index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty())
+		return false;
+
+	job = queue.jobs.back();
+	queue.jobs.pop_back();
+	return true;
+}
+
+static bool stealJob(int index, Job& job)
+{
+	JobQueue& queue = sQueue[index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty())
+		return false;
+
+	job = queue.jobs.front();
+	queue.jobs.pop_front();
+	return true;
+}
+
+// Own queue first, then the others starting from the next thread, so the thieves spread out
+static bool findJob(Job& job)
+{
+	if (sNumPending.load(std::memory_order_acquire) == 0)
+		return false;
+
+	if (popJob(tThreadIndex, job))
+		return true;
+	for (int k = 1; k < sNumThread; k++) {
+		if (stealJob((tThreadIndex + k) % sNumThread, job))
+			return true;
+	}
+	return false;
+}
+
+static void runJob(const Job& job)
+{
+	sNumPending.fetch_sub(1, std::memory_order_relaxed);
+	if (job.task != NULL) {
+		(*job.task)();
+		return;
+	}
+	(*job.func)(job.begin, job.end);
+	job.numLeft->fetch_sub(1, std::memory_order_release);
+}
+
+static void workerMain(int index)
+{
+	tThreadIndex = index;
+
+	int numFail = 0;
+	while (!sQuit.load(std::memory_order_relaxed)) {
+		Job job;
+		if (findJob(job)) {
+			runJob(job);
+			numFail = 0;
+			continue;
+		}
+
+		// spin a little, a frame pushes its jobs in bursts
+		if (++numFail < JOB_SPIN) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sSleepMutex);
+		sSleepCond.wait(lock, [] { return sNumPending.load() > 0 || sQuit.load(); });
+		numFail = 0;
+	}
+}
+
+
+// -------------------------------------------
+// Init & Shutdown
+// -------------------------------------------
+
+void JobSystemInit(int numThread)
+{
+	JobSystemShutdown();
+
+	if (numThread <= 0)
+		numThread = (int)std::thread::hardware_concurrency();
+	if (numThread < 1)
+		numThread = 1;
+	if (numThread > JOB_THREAD_MAX)
+		numThread = JOB_THREAD_MAX;
+
+	sQuit = false;
+	sNumThread = numThread;
+	for (int i = 1; i < numThread; i++) {
+		sWorker.push_back(std::thread(workerMain, i));
+	}
+}
+
+void JobSystemShutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(sSleepMutex);
+		sQuit = true;
+	}
+	sSleepCond.notify_all();
+
+	for (size_t i = 0; i < sWorker.size(); i++) {
+		sWorker[i].join();
+	}
+	sWorker.clear();
+	sNumThread = 1;
+}
+
+int JobSystemNumThread()
+{
+	return sNumThread;
+}
+
+
+// -------------------------------------------
+// Jobs
+// -------------------------------------------
+
+void JobParallelFor(int count, int grain, const std::function<void(int, int)>& func)
+{
+	if (count <= 0)
+		return;
+	if (grain < 1)
+		grain = 1;
+
+	// not worth waking anybody up
+	int numJob = (count + grain - 1) / grain;
+	if (numJob == 1 || sNumThread == 1) {
+		func(0, count);
+		return;
+	}
+
+	// deal the jobs round-robin, the first ones on the own queue
+	std::atomic<int> numLeft(numJob);
+	for (int j = 0; j < numJob; j++) {
+		Job job;
+		job.func = &func;
+		job.task = NULL;
+		job.begin = j * grain;
+		job.end = (j + 1) * grain < count ? (j + 1) * grain : count;
+		job.numLeft = &numLeft;
+
+		JobQueue& queue = sQueue[(tThreadIndex + j) % sNumThread];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(sSleepMutex);
+		sNumPending.fetch_add(numJob, std::memory_order_release);
+	}
+	sSleepCond.notify_all();
+
+	// help until all the jobs are done, these may be jobs of another JobParallelFor()
+	while (numLeft.load(std::memory_order_acquire) > 0) {
+		Job job;
+		if (findJob(job))
+			runJob(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobRun(const std::function<void()>& func)
+{
+	Job job;
+	job.func = NULL;
+	job.task = &func;
+	job.begin = 0;
+	job.end = 0;
+	job.numLeft = NULL;
+
+	{
+		JobQueue& queue = sQueue[tThreadIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(sSleepMutex);
+		sNumPending.fetch_add(1, std::memory_order_release);
+	}
+	sSleepCond.notify_one();
+}
+
+bool JobHelp()
+{
+	Job job;
+	if (!findJob(job))
+		return false;
+
+	runJob(job);
+	return true;
+}
@@ -0,0 +1,28 @@
+#ifndef JOB_SYSTEM
+#define JOB_SYSTEM
+
+#include <functional>
+
+// -------------------------------------------
+// Work-stealing thread pool
+//	- every thread (the main thread and the workers) has its own job queue,
+//	  a thread takes jobs from the back of its own queue and steals from the front of the others
+//	- JobParallelFor() cuts [0, count) into jobs of grain items, spreads them over the queues
+//	  and works on them until they are all done, so it can also be called from inside a job
+//	- with no worker (JobSystemInit(1) or never initialized) everything runs on the calling thread
+// -------------------------------------------
+
+void JobSystemInit(int numThread);		// numThread includes the main thread, 0 = one per core
+void JobSystemShutdown();
+int  JobSystemNumThread();				// The main thread + the workers
+
+// Call func(begin, end) on sub-ranges of [0, count), at most grain items each, return when all are done
+void JobParallelFor(int count, int grain, const std::function<void(int, int)>& func);
+
+// Push one job on the queue of the calling thread and return, func must stay alive until it has run
+void JobRun(const std::function<void()>& func);
+// Run one queued job on the calling thread, false when there was none, to help while waiting
+bool JobHelp();
+
+
+#endif // JOB_SYSTEM
@@ -0,0 +1,286 @@
+#include "SpatialGrid.h"
+#include <math.h>
+#include <vector>
+
+#define SPATIAL_GRID_PER_CELL		4				// Objects per cell the cell size aims for
+#define SPATIAL_GRID_MIN_CELL		4.0f			// Smallest cell size, in world units
+#define SPATIAL_GRID_MAX_CELL		(1 << 20)		// Most cells in a grid
+#define SPATIAL_GRID_CELL_PER_OBJ	16				// Most cells per object, the build clears and sums every cell
+
+// -------------------------------------------
+// Grid
+// -------------------------------------------
+
+struct SpatialGrid
+{
+	glm::vec2					min;
+	float						cellSize;
+	float						invCellSize;
+	int							numX;
+	int							numY;
+
+	std::vector<int>			cellStart;		// Objects of cell c are [cellStart[c], cellStart[c + 1]), numX * numY + 1 entries
+	std::vector<glm::vec2>		position;		// Sorted by cell
+	std::vector<glm::vec2>		scale;
+	std::vector<GameObjHandle>	handle;
+	std::vector<int>			index;			// Index in the bucket, the counting sort keeps the bucket order inside a cell
+	glm::vec2					maxScale;		// Largest scale of the objects, how far a box goes out of its cell
+	std::vector<int>			objCell;		// Cell of each object in bucket order, build only
+};
+
+static int cellCoord(float x, float min, float invCellSize, int num)
+{
+	int c = (int)floorf((x - min) * invCellSize);
+	return c < 0 ? 0 : (c >= num ? num - 1 : c);
+}
+
+SpatialGrid* SpatialGridCreate()
+{
+	SpatialGrid* pGrid = new SpatialGrid;
+	pGrid->min = glm::vec2(0.0f);
+	pGrid->cellSize = 1.0f;
+	pGrid->invCellSize = 1.0f;
+	pGrid->numX = 1;
+	pGrid->numY = 1;
+	pGrid->cellStart.assign(2, 0);
+	pGrid->maxScale = glm::vec2(0.0f);
+	return pGrid;
+}
+
+void SpatialGridDestroy(SpatialGrid* pGrid)
+{
+	delete pGrid;
+}
+
+void SpatialGridBuild(SpatialGrid* pGrid, int type, glm::vec2 min, glm::vec2 max, float cellSize)
+{
+	int count = GameObjCount(type);
+
+	// the grid covers every object, the cells must bound what they hold for the cone queries
+	glm::vec2 maxScale(0.0f);
+	for (int c = 0; c < GameObjNumChunk(type); c++) {
+		const GameObjArrays& obj = GameObjChunkData(type, c);
+		int chunkCount = GameObjChunkCount(type, c);
+
+		for (int i = 0; i < chunkCount; i++) {
+			min = glm::min(min, obj.position[i]);
+			max = glm::max(max, obj.position[i]);
+			maxScale = glm::max(maxScale, glm::abs(obj.scale[i]));
+		}
+	}
+
+	glm::vec2 size = glm::max(max - min, glm::vec2(SPATIAL_GRID_MIN_CELL));
+
+	// a few objects per cell or the size of the objects, not too many cells
+	//	- larger cells only make the queries read more objects per cell, a few or no objects
+	//	  (small scale, empty bucket) would otherwise spread over a large array of empty cells
+	if (cellSize == SPATIAL_GRID_CELL_AUTO)
+		cellSize = sqrtf(size.x * size.y * SPATIAL_GRID_PER_CELL / glm::max(count, 1));
+	else if (cellSize < 0.0f)
+		cellSize = glm::max(maxScale.x, maxScale.y);
+	cellSize = glm::max(cellSize, SPATIAL_GRID_MIN_CELL);
+	float maxCell = (float)glm::min(glm::max(count, 1) * SPATIAL_GRID_CELL_PER_OBJ, SPATIAL_GRID_MAX_CELL);
+	while ((size.x / cellSize + 1.0f) * (size.y / cellSize + 1.0f) > maxCell) {
+		cellSize *= 2.0f;
+	}
+
+	pGrid->min = min;
+	pGrid->cellSize = cellSize;
+	pGrid->invCellSize = 1.0f / cellSize;
+	pGrid->numX = (int)(size.x / cellSize) + 1;
+	pGrid->numY = (int)(size.y / cellSize) + 1;
+
+	// the arrays keep their capacity from one build to the next, only the cells in use are cleared
+	int numCell = pGrid->numX * pGrid->numY;
+	pGrid->cellStart.assign(numCell + 1, 0);
+	pGrid->position.resize(count);
+	pGrid->scale.resize(count);
+	pGrid->handle.resize(count);
+	pGrid->index.resize(count);
+	pGrid->maxScale = maxScale;
+	pGrid->objCell.resize(count);
+
+	// count the objects of each cell
+	int n = 0;
+	for (int c = 0; c < GameObjNumChunk(type); c++) {
+		const GameObjArrays& obj = GameObjChunkData(type, c);
+		int chunkCount = GameObjChunkCount(type, c);
+
+		for (int i = 0; i < chunkCount; i++, n++) {
+			int x = cellCoord(obj.position[i].x, min.x, pGrid->invCellSize, pGrid->numX);
+			int y = cellCoord(obj.position[i].y, min.y, pGrid->invCellSize, pGrid->numY);
+			pGrid->objCell[n] = y * pGrid->numX + x;
+			pGrid->cellStart[pGrid->objCell[n] + 1]++;
+		}
+	}
+
+	// cellStart[c] = first object of cell c
+	for (int c = 0; c < numCell; c++) {
+		pGrid->cellStart[c + 1] += pGrid->cellStart[c];
+	}
+
+	// place the objects, cellStart[c] moves to the end of the cell and is shifted back after
+	n = 0;
+	for (int c = 0; c < GameObjNumChunk(type); c++) {
+		const GameObjArrays& obj = GameObjChunkData(type, c);
+		int chunkCount = GameObjChunkCount(type, c);
+
+		for (int i = 0; i < chunkCount; i++, n++) {
+			int dst = pGrid->cellStart[pGrid->objCell[n]]++;
+			pGrid->position[dst] = obj.position[i];
+			pGrid->scale[dst] = obj.scale[i];
+			pGrid->handle[dst] = obj.handle[i];
+			pGrid->index[dst] = (c << GAME_OBJ_CHUNK_SHIFT) + i;
+		}
+	}
+	for (int c = numCell; c > 0; c--) {
+		pGrid->cellStart[c] = pGrid->cellStart[c - 1];
+	}
+	pGrid->cellStart[0] = 0;
+}
+
+int SpatialGridCount(const SpatialGrid* pGrid)
+{
+	return (int)pGrid->position.size();
+}
+
+
+// -------------------------------------------
+// Queries
+// -------------------------------------------
+
+// Keep the k closest in hit[0..numHit), sorted
+static void addHit(SpatialGridHit* hit, int& numHit, int k, GameObjHandle handle, glm::vec2 position, float distance2)
+{
+	if (numHit == k && distance2 >= hit[k - 1].distance2)
+		return;
+
+	int i = (numHit < k) ? numHit++ : k - 1;
+	for (; i > 0 && hit[i - 1].distance2 > distance2; i--) {
+		hit[i] = hit[i - 1];
+	}
+	hit[i].handle = handle;
+	hit[i].position = position;
+	hit[i].distance2 = distance2;
+}
+
+// The cell may hold a point of the cone, from its bounding circle
+//	- the angle to the center of the cell must be within the half angle + the angle the circle covers
+static bool cellInCone(const SpatialGrid* pGrid, int x, int y, glm::vec2 pos, glm::vec2 dir, float cosHalfAngle, float sinHalfAngle)
+{
+	glm::vec2 center = pGrid->min + (glm::vec2(x, y) + 0.5f) * pGrid->cellSize;
+	glm::vec2 v = center - pos;
+	float length = glm::length(v);
+	float radius = pGrid->cellSize * 0.7072f;
+	if (length <= radius)
+		return true;
+
+	float sinCircle = radius / length;
+	float cosCircle = sqrtf(1.0f - sinCircle * sinCircle);
+	return glm::dot(v, dir) >= length * (cosHalfAngle * cosCircle - sinHalfAngle * sinCircle);
+}
+
+// Visit the cells ring by ring around the cell of pos, stop once no cell left can hold anything closer
+//	- the cells of ring r are at least (r - 1) * cellSize away from pos
+//	- cosHalfAngle < -1 = no cone
+//	- a cone narrower than a half plane also skips the cells out of it, and stops at the first ring
+//	  with no cell in it: the grid is convex, a point of the cone further out would be seen through that ring
+static int query(const SpatialGrid* pGrid, glm::vec2 pos, glm::vec2 dir, float cosHalfAngle,
+	float maxDist, int k, SpatialGridHit* outHit)
+{
+	if (k <= 0 || pGrid->position.empty())
+		return 0;
+
+	bool	cone = cosHalfAngle >= -1.0f;
+	bool	cullCell = cosHalfAngle > 0.0f;
+	float	sinHalfAngle = cullCell ? sqrtf(1.0f - cosHalfAngle * cosHalfAngle) : 1.0f;
+	float	maxDist2 = maxDist * maxDist;
+	int		numHit = 0;
+	int		cx = cellCoord(pos.x, pGrid->min.x, pGrid->invCellSize, pGrid->numX);
+	int		cy = cellCoord(pos.y, pGrid->min.y, pGrid->invCellSize, pGrid->numY);
+	int		numRing = glm::max(pGrid->numX, pGrid->numY);
+	glm::vec2 max = pGrid->min + glm::vec2(pGrid->numX, pGrid->numY) * pGrid->cellSize;
+	bool	inside = pos.x >= pGrid->min.x && pos.y >= pGrid->min.y && pos.x < max.x && pos.y < max.y;
+
+	for (int r = 0; r < numRing; r++) {
+		float ringDist = (r - 1) * pGrid->cellSize;
+		if (r > 0 && (ringDist > maxDist || (numHit == k && outHit[k - 1].distance2 <= ringDist * ringDist)))
+			break;
+
+		int numInCone = 0;
+
+		int y0 = glm::max(cy - r, 0), y1 = glm::min(cy + r, pGrid->numY - 1);
+		for (int y = y0; y <= y1; y++) {
+
+			// the full row on the top and bottom of the ring, the two ends on the other rows
+			bool edgeRow = (y == cy - r || y == cy + r);
+			int step = edgeRow ? 1 : 2 * r;
+			for (int x = cx - r; x <= cx + r; x += step) {
+				if (x < 0 || x >= pGrid->numX)
+					continue;
+				if (cullCell && !cellInCone(pGrid, x, y, pos, dir, cosHalfAngle, sinHalfAngle))
+					continue;
+				numInCone++;
+
+				int cell = y * pGrid->numX + x;
+				for (int i = pGrid->cellStart[cell]; i < pGrid->cellStart[cell + 1]; i++) {
+					glm::vec2 d = pGrid->position[i] - pos;
+					float distance2 = glm::dot(d, d);
+					if (distance2 > maxDist2)
+						continue;
+					if (cone && glm::dot(d, dir) < cosHalfAngle * sqrtf(distance2))
+						continue;
+
+					addHit(outHit, numHit, k, pGrid->handle[i], pGrid->position[i], distance2);
+				}
+			}
+		}
+
+		if (cullCell && inside && numInCone == 0)
+			break;
+	}
+
+	return numHit;
+}
+
+int SpatialGridNearest(const SpatialGrid* pGrid, glm::vec2 pos, float maxDist, int k, SpatialGridHit* outHit)
+{
+	return query(pGrid, pos, glm::vec2(0.0f), -2.0f, maxDist, k, outHit);
+}
+
+int SpatialGridNearestInCone(const SpatialGrid* pGrid, glm::vec2 pos, glm::vec2 dir, float cosHalfAngle,
+	float maxDist, int k, SpatialGridHit* outHit)
+{
+	return query(pGrid, pos, dir, cosHalfAngle, maxDist, k, outHit);
+}
+
+int SpatialGridOverlap(const SpatialGrid* pGrid, glm::vec2 pos, glm::vec2 halfSize, std::vector<int>& outIndex)
+{
+	if (pGrid->position.empty())
+		return 0;
+
+	// the cells a box overlapping pos +- halfSize can be stored in
+	glm::vec2 reach = halfSize + pGrid->maxScale;
+	int x0 = cellCoord(pos.x - reach.x, pGrid->min.x, pGrid->invCellSize, pGrid->numX);
+	int x1 = cellCoord(pos.x + reach.x, pGrid->min.x, pGrid->invCellSize, pGrid->numX);
+	int y0 = cellCoord(pos.y - reach.y, pGrid->min.y, pGrid->invCellSize, pGrid->numY);
+	int y1 = cellCoord(pos.y + reach.y, pGrid->min.y, pGrid->invCellSize, pGrid->numY);
+
+	int numFound = 0;
+	for (int y = y0; y <= y1; y++) {
+
+		// the cells of a row are next to each other, so are their objects
+		int first = pGrid->cellStart[y * pGrid->numX + x0];
+		int last = pGrid->cellStart[y * pGrid->numX + x1 + 1];
+		for (int i = first; i < last; i++) {
+			glm::vec2 d = glm::abs(pGrid->position[i] - pos);
+			glm::vec2 extent = pGrid->scale[i] + halfSize;
+			if (d.x <= extent.x && d.y <= extent.y) {
+				outIndex.push_back(pGrid->index[i]);
+				numFound++;
+			}
+		}
+	}
+
+	return numFound;
+}
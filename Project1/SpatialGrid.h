@@ -0,0 +1,48 @@
+#ifndef SPATIAL_GRID
+#define SPATIAL_GRID
+
+#include <vector>
+#include "GameObj.h"
+
+// -------------------------------------------
+// Uniform grid over the objects of one bucket
+//	- SpatialGridBuild() copies the positions and handles of the bucket, sorted by cell (counting sort),
+//	  so the objects of a cell are next to each other and a query only reads the cells around it
+//	- the cell size follows the number of objects (a few objects per cell) for the nearest queries,
+//	  or the size of the objects for the overlap queries
+//	- the grid covers [min, max] and grows to the objects outside it
+//	- the box of an object is its position +- its scale, the extent the collision broadphase tests
+//	- the queries only read the grid, they can run on several threads at once, not during a build
+// -------------------------------------------
+
+struct SpatialGrid;
+
+struct SpatialGridHit
+{
+	GameObjHandle	handle;
+	glm::vec2		position;
+	float			distance2;			// Squared distance to the query position
+};
+
+SpatialGrid* SpatialGridCreate();
+void SpatialGridDestroy(SpatialGrid* pGrid);
+
+#define SPATIAL_GRID_CELL_AUTO		0.0f			// Cell size from the number of objects
+#define SPATIAL_GRID_CELL_SCALE		-1.0f			// Cell size = the largest scale, an overlap query reads 3x3 cells at most
+
+// Index the objects of the type, including the destroyed objects that are not flushed yet
+void SpatialGridBuild(SpatialGrid* pGrid, int type, glm::vec2 min, glm::vec2 max, float cellSize);
+int  SpatialGridCount(const SpatialGrid* pGrid);
+
+// The k objects closest to pos within maxDist, closest first, return how many were found (<= k)
+int SpatialGridNearest(const SpatialGrid* pGrid, glm::vec2 pos, float maxDist, int k, SpatialGridHit* outHit);
+// Same, only the objects in the cone from pos around dir (unit), cosHalfAngle = cos of the half opening angle
+int SpatialGridNearestInCone(const SpatialGrid* pGrid, glm::vec2 pos, glm::vec2 dir, float cosHalfAngle,
+	float maxDist, int k, SpatialGridHit* outHit);
+
+// Append to outIndex the objects whose box overlaps pos +- halfSize, return how many were appended
+//	- the index of an object in its bucket when the grid was built, chunk = index >> GAME_OBJ_CHUNK_SHIFT
+int SpatialGridOverlap(const SpatialGrid* pGrid, glm::vec2 pos, glm::vec2 halfSize, std::vector<int>& outIndex);
+
+
+#endif // SPATIAL_GRID
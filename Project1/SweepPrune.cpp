@@ -0,0 +1,201 @@
+#include "SweepPrune.h"
+#include <algorithm>
+#include <vector>
+
+#define SWEEP_PRUNE_PAD			1.0f			// Added to the x extent of the boxes, covers the rounding of position +- scale
+#define SWEEP_PRUNE_SLOT_MASK	((1 << GAME_OBJ_SLOT_BITS) - 1)
+
+// -------------------------------------------
+// List
+// -------------------------------------------
+
+struct SweepPruneEntry
+{
+	float			minX;				// Sort key
+	float			maxX;
+	glm::vec2		position;
+	glm::vec2		scale;
+	GameObjHandle	handle;
+	int				index;				// In its bucket
+	int				group;				// -1 = box, else the point type
+	unsigned int	stamp;				// Update that last saw the object
+};
+
+// A box the sweep is in, copied so the boxes tested against a point are next to each other
+struct SweepPruneActive
+{
+	float			maxX;
+	glm::vec2		position;
+	glm::vec2		scale;
+	int				entry;
+};
+
+struct SweepPrune
+{
+	int								boxType;
+	std::vector<int>				pointType;
+
+	std::vector<SweepPruneEntry>	entry;			// Sorted by minX, the boxes first on a tie
+	std::vector<SweepPruneEntry>	added;			// Objects new in this update
+	std::vector<SweepPruneEntry>	merged;
+	std::vector<int>				slotEntry;		// Entry of each handle slot, checked against the handle
+	std::vector<SweepPruneActive>	active;			// Boxes that span the x of the sweep
+	unsigned int					stamp;
+	int								numMove;
+};
+
+static bool entryLess(const SweepPruneEntry& a, const SweepPruneEntry& b)
+{
+	return a.minX < b.minX || (a.minX == b.minX && a.group < b.group);
+}
+
+SweepPrune* SweepPruneCreate(int boxType, const int* pointType, int numPointType)
+{
+	SweepPrune* pSap = new SweepPrune;
+	pSap->boxType = boxType;
+	pSap->pointType.assign(pointType, pointType + numPointType);
+	pSap->stamp = 0;
+	pSap->numMove = 0;
+	return pSap;
+}
+
+void SweepPruneDestroy(SweepPrune* pSap)
+{
+	delete pSap;
+}
+
+void SweepPruneUpdate(SweepPrune* pSap)
+{
+	pSap->stamp++;
+	pSap->added.clear();
+
+	// refresh the objects already in the list, in place, the others go to added
+	for (int g = -1; g < (int)pSap->pointType.size(); g++) {
+		int type = (g < 0) ? pSap->boxType : pSap->pointType[g];
+
+		for (int c = 0; c < GameObjNumChunk(type); c++) {
+			const GameObjArrays& obj = GameObjChunkData(type, c);
+			int chunkCount = GameObjChunkCount(type, c);
+
+			for (int i = 0; i < chunkCount; i++) {
+				GameObjHandle handle = obj.handle[i];
+				int slot = handle & SWEEP_PRUNE_SLOT_MASK;
+				int e = (slot < (int)pSap->slotEntry.size()) ? pSap->slotEntry[slot] : -1;
+
+				SweepPruneEntry* pEntry;
+				if (e >= 0 && e < (int)pSap->entry.size() && pSap->entry[e].handle == handle) {
+					pEntry = &pSap->entry[e];
+				}
+				else {
+					pSap->added.push_back(SweepPruneEntry());
+					pEntry = &pSap->added.back();
+					pEntry->handle = handle;
+				}
+
+				pEntry->position = obj.position[i];
+				pEntry->scale = obj.scale[i];
+				pEntry->index = (c << GAME_OBJ_CHUNK_SHIFT) + i;
+				pEntry->group = g;
+				pEntry->stamp = pSap->stamp;
+				pEntry->minX = obj.position[i].x;
+				pEntry->maxX = obj.position[i].x;
+				if (g < 0) {
+					pEntry->minX -= obj.scale[i].x + SWEEP_PRUNE_PAD;
+					pEntry->maxX += obj.scale[i].x + SWEEP_PRUNE_PAD;
+				}
+			}
+		}
+	}
+
+	// drop the objects that are gone, the order of the others is kept
+	std::vector<SweepPruneEntry>& entry = pSap->entry;
+	int num = 0;
+	for (size_t e = 0; e < entry.size(); e++) {
+		if (entry[e].stamp == pSap->stamp)
+			entry[num++] = entry[e];
+	}
+	entry.resize(num);
+
+	// insertion sort from the last order, an object only moves past the few it crossed
+	pSap->numMove = 0;
+	for (int e = 1; e < num; e++) {
+		if (!entryLess(entry[e], entry[e - 1]))
+			continue;
+
+		SweepPruneEntry moved = entry[e];
+		int dst = e;
+		for (; dst > 0 && entryLess(moved, entry[dst - 1]); dst--) {
+			entry[dst] = entry[dst - 1];
+		}
+		entry[dst] = moved;
+		pSap->numMove += e - dst;
+	}
+
+	// the new objects have no last order, sort them and merge them in
+	if (!pSap->added.empty()) {
+		std::sort(pSap->added.begin(), pSap->added.end(), entryLess);
+		pSap->merged.resize(entry.size() + pSap->added.size());
+		std::merge(entry.begin(), entry.end(), pSap->added.begin(), pSap->added.end(), pSap->merged.begin(), entryLess);
+		entry.swap(pSap->merged);
+	}
+
+	for (size_t e = 0; e < entry.size(); e++) {
+		int slot = entry[e].handle & SWEEP_PRUNE_SLOT_MASK;
+		if (slot >= (int)pSap->slotEntry.size())
+			pSap->slotEntry.resize(slot + 1, -1);
+		pSap->slotEntry[slot] = (int)e;
+	}
+}
+
+int SweepPruneCount(const SweepPrune* pSap)
+{
+	return (int)pSap->entry.size();
+}
+
+int SweepPruneNumMove(const SweepPrune* pSap)
+{
+	return pSap->numMove;
+}
+
+
+// -------------------------------------------
+// Sweep
+// -------------------------------------------
+
+int SweepPruneFindPairs(SweepPrune* pSap, std::vector<SweepPrunePair>& outPair)
+{
+	const std::vector<SweepPruneEntry>& entry = pSap->entry;
+	std::vector<SweepPruneActive>& active = pSap->active;
+	int numFound = 0;
+
+	active.clear();
+	for (int e = 0; e < (int)entry.size(); e++) {
+		if (entry[e].group < 0) {
+			SweepPruneActive box = { entry[e].maxX, entry[e].position, entry[e].scale, e };
+			active.push_back(box);
+			continue;
+		}
+
+		// the boxes that ended before this x are done, the others are tested
+		const SweepPruneEntry& point = entry[e];
+		for (size_t k = 0; k < active.size(); ) {
+			const SweepPruneActive& box = active[k];
+			if (box.maxX < point.minX) {
+				active[k] = active.back();
+				active.pop_back();
+				continue;
+			}
+
+			glm::vec2 d = glm::abs(point.position - box.position);
+			if (d.x <= box.scale.x && d.y <= box.scale.y) {
+				const SweepPruneEntry& boxEntry = entry[box.entry];
+				SweepPrunePair pair = { boxEntry.handle, point.handle, boxEntry.index, point.index, point.group };
+				outPair.push_back(pair);
+				numFound++;
+			}
+			k++;
+		}
+	}
+
+	return numFound;
+}
@@ -0,0 +1,41 @@
+#ifndef SWEEP_PRUNE
+#define SWEEP_PRUNE
+
+#include <vector>
+#include "GameObj.h"
+
+// -------------------------------------------
+// Incremental sweep and prune along x
+//	- boxes (the objects of one bucket, position +- scale) against points
+//	  (the objects of a few other buckets), only the box/point pairs are reported
+//	- SweepPruneUpdate() keeps the objects sorted from one update to the next: they barely move in
+//	  an update, so an insertion sort of the last order is about O(n); the new objects are sorted
+//	  on their own and merged in, the stale handles are dropped
+//	- SweepPruneFindPairs() sweeps the sorted list once, a point is only tested against the boxes
+//	  that span its x
+// -------------------------------------------
+
+struct SweepPrune;
+
+struct SweepPrunePair
+{
+	GameObjHandle	box;
+	GameObjHandle	point;
+	int				boxIndex;			// Index in its bucket at the last update
+	int				pointIndex;
+	int				group;				// Index of the point type in the list given to SweepPruneCreate()
+};
+
+SweepPrune* SweepPruneCreate(int boxType, const int* pointType, int numPointType);
+void SweepPruneDestroy(SweepPrune* pSap);
+
+// Read the buckets, once per update before the queries
+void SweepPruneUpdate(SweepPrune* pSap);
+int  SweepPruneCount(const SweepPrune* pSap);
+int  SweepPruneNumMove(const SweepPrune* pSap);		// Places the insertion sort moved the objects by in the last update
+
+// Append the box/point pairs that overlap in x and y, in sweep order, return how many were appended
+int SweepPruneFindPairs(SweepPrune* pSap, std::vector<SweepPrunePair>& outPair);
+
+
+#endif // SWEEP_PRUNE
@@ -0,0 +1,248 @@
+#include "TaskGraph.h"
+#include "JobSystem.h"
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock	TaskClock;
+
+// -------------------------------------------
+// Graph
+// -------------------------------------------
+
+struct TaskNode
+{
+	std::string				name;
+	std::function<void()>	func;
+	std::function<void()>	job;			// func + timing + release the next nodes, what the job system runs
+	unsigned int			reads;
+	unsigned int			writes;
+	bool					mainThread;
+
+	std::vector<int>		prev;			// Nodes this one waits for, without the ones already implied by another
+	std::vector<bool>		after;			// after[i] = this node always runs after node i
+	std::vector<int>		next;			// Nodes waiting for this one
+	std::atomic<int>		numWait;		// prev nodes not done yet in the current run
+
+	double					start;			// ms since the start of the run, last run
+	double					end;
+	double					total;			// Sum of the durations since the last report, in ms
+};
+
+struct TaskGraph
+{
+	std::string				name;
+	std::vector<TaskNode*>	node;
+
+	TaskClock::time_point	runStart;
+	std::atomic<int>		numLeft;		// Nodes not done yet in the current run
+	std::mutex				mainMutex;
+	std::vector<int>		mainReady;		// mainThread nodes ready to run
+
+	int						numRun;			// Runs since the last report
+	double					total;			// Sum of the run times since the last report, in ms
+};
+
+static int	sReportRun;						// Print the report every sReportRun runs, 0 = never
+
+
+static double msSince(TaskClock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(TaskClock::now() - start).count();
+}
+
+static void readyNode(TaskGraph* pGraph, int index)
+{
+	TaskNode* pNode = pGraph->node[index];
+	if (pNode->mainThread) {
+		std::lock_guard<std::mutex> lock(pGraph->mainMutex);
+		pGraph->mainReady.push_back(index);
+	}
+	else {
+		JobRun(pNode->job);
+	}
+}
+
+static void runNode(TaskGraph* pGraph, int index)
+{
+	TaskNode* pNode = pGraph->node[index];
+
+	pNode->start = msSince(pGraph->runStart);
+	pNode->func();
+	pNode->end = msSince(pGraph->runStart);
+	pNode->total += pNode->end - pNode->start;
+
+	for (size_t k = 0; k < pNode->next.size(); k++) {
+		if (pGraph->node[pNode->next[k]]->numWait.fetch_sub(1) == 1)
+			readyNode(pGraph, pNode->next[k]);
+	}
+
+	// last, TaskGraphRun() returns as soon as this reaches 0
+	pGraph->numLeft.fetch_sub(1, std::memory_order_release);
+}
+
+TaskGraph* TaskGraphCreate(const char* name)
+{
+	TaskGraph* pGraph = new TaskGraph;
+	pGraph->name = name;
+	pGraph->numLeft = 0;
+	pGraph->numRun = 0;
+	pGraph->total = 0.0;
+	return pGraph;
+}
+
+void TaskGraphDestroy(TaskGraph* pGraph)
+{
+	if (pGraph == NULL)
+		return;
+
+	for (size_t i = 0; i < pGraph->node.size(); i++) {
+		delete pGraph->node[i];
+	}
+	delete pGraph;
+}
+
+int TaskGraphAdd(TaskGraph* pGraph, const char* name, unsigned int reads, unsigned int writes, bool mainThread,
+	const std::function<void()>& func)
+{
+	int index = (int)pGraph->node.size();
+
+	TaskNode* pNode = new TaskNode;
+	pNode->name = name;
+	pNode->func = func;
+	pNode->job = [pGraph, index]() { runNode(pGraph, index); };
+	pNode->reads = reads;
+	pNode->writes = writes;
+	pNode->mainThread = mainThread;
+	pNode->numWait = 0;
+	pNode->start = 0.0;
+	pNode->end = 0.0;
+	pNode->total = 0.0;
+
+	// write after write, read after write, write after read
+	//	- from the last node back, a node already before one of the prev nodes needs no edge of its own
+	pNode->after.assign(index, false);
+	for (int i = index - 1; i >= 0; i--) {
+		TaskNode* pPrev = pGraph->node[i];
+		bool conflict = (pPrev->writes & (reads | writes)) != 0 || (pPrev->reads & writes) != 0;
+		if (!conflict || pNode->after[i])
+			continue;
+
+		pNode->prev.push_back(i);
+		pPrev->next.push_back(index);
+		pNode->after[i] = true;
+		for (int k = 0; k < i; k++) {
+			if (pPrev->after[k])
+				pNode->after[k] = true;
+		}
+	}
+
+	pGraph->node.push_back(pNode);
+	return index;
+}
+
+void TaskGraphRun(TaskGraph* pGraph)
+{
+	int numNode = (int)pGraph->node.size();
+
+	pGraph->runStart = TaskClock::now();
+	pGraph->numLeft = numNode;
+	for (int i = 0; i < numNode; i++) {
+		pGraph->node[i]->numWait = (int)pGraph->node[i]->prev.size();
+	}
+	for (int i = 0; i < numNode; i++) {
+		if (pGraph->node[i]->prev.empty())
+			readyNode(pGraph, i);
+	}
+
+	// run the mainThread nodes here, help the workers with the others
+	while (pGraph->numLeft.load(std::memory_order_acquire) > 0) {
+		int index = -1;
+		{
+			std::lock_guard<std::mutex> lock(pGraph->mainMutex);
+			if (!pGraph->mainReady.empty()) {
+				index = pGraph->mainReady.back();
+				pGraph->mainReady.pop_back();
+			}
+		}
+
+		if (index >= 0)
+			runNode(pGraph, index);
+		else if (!JobHelp())
+			std::this_thread::yield();
+	}
+
+	pGraph->total += msSince(pGraph->runStart);
+	pGraph->numRun++;
+	if (sReportRun > 0 && pGraph->numRun >= sReportRun)
+		TaskGraphReport(pGraph);
+}
+
+
+// -------------------------------------------
+// Report
+// -------------------------------------------
+
+void TaskGraphReport(TaskGraph* pGraph)
+{
+	int numNode = (int)pGraph->node.size();
+	if (pGraph->numRun == 0 || numNode == 0)
+		return;
+
+	// longest chain of average durations, the nodes are already in dependency order
+	std::vector<double> length(numNode);
+	std::vector<int> from(numNode, -1);
+	int last = 0;
+	for (int i = 0; i < numNode; i++) {
+		TaskNode* pNode = pGraph->node[i];
+		double before = 0.0;
+		for (size_t k = 0; k < pNode->prev.size(); k++) {
+			if (length[pNode->prev[k]] > before) {
+				before = length[pNode->prev[k]];
+				from[i] = pNode->prev[k];
+			}
+		}
+		length[i] = before + pNode->total / pGraph->numRun;
+		if (length[i] > length[last])
+			last = i;
+	}
+
+	double run = pGraph->total / pGraph->numRun;
+	double sum = 0.0;
+	printf("TaskGraph %s: %d runs, %.3f ms per run, %d threads\n", pGraph->name.c_str(), pGraph->numRun, run, JobSystemNumThread());
+	for (int i = 0; i < numNode; i++) {
+		TaskNode* pNode = pGraph->node[i];
+		double ms = pNode->total / pGraph->numRun;
+		sum += ms;
+
+		printf("  %-20s %8.3f ms  %s after", pNode->name.c_str(), ms, pNode->mainThread ? "main" : "    ");
+		for (size_t k = 0; k < pNode->prev.size(); k++) {
+			printf(" %s", pGraph->node[pNode->prev[k]]->name.c_str());
+		}
+		printf("\n");
+
+		pNode->total = 0.0;
+	}
+
+	// walk the chain back from its end
+	std::vector<int> path;
+	for (int i = last; i >= 0; i = from[i]) {
+		path.push_back(i);
+	}
+	printf("  critical path %.3f ms (sum of the nodes %.3f ms):", length[last], sum);
+	for (int k = (int)path.size() - 1; k >= 0; k--) {
+		printf(" %s%s", pGraph->node[path[k]]->name.c_str(), k > 0 ? " ->" : "\n");
+	}
+
+	pGraph->numRun = 0;
+	pGraph->total = 0.0;
+}
+
+void TaskGraphEnableReport(int numRun)
+{
+	sReportRun = numRun;
+}
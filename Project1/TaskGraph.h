@@ -0,0 +1,31 @@
+#ifndef TASK_GRAPH
+#define TASK_GRAPH
+
+#include <functional>
+
+// -------------------------------------------
+// Task graph over the job system
+//	- a node is one phase of the frame with the resources it reads and writes (a bit mask, the caller names the bits)
+//	- a node runs after every node added before it that writes what it reads or writes, or reads what it writes,
+//	  so the graph runs the phases like the serial sequence would, and the independent ones at the same time
+//	- mainThread nodes (input, GL) only run on the thread calling TaskGraphRun(), which must be the main thread
+//	- TaskGraphRun() can be called from a mainThread node of another graph
+//	- the time of each node is kept, the report shows the average and the critical path
+// -------------------------------------------
+
+struct TaskGraph;
+
+TaskGraph* TaskGraphCreate(const char* name);
+void TaskGraphDestroy(TaskGraph* pGraph);
+
+// Return the node index, the nodes are run in dependency order, never before a node they depend on
+int  TaskGraphAdd(TaskGraph* pGraph, const char* name, unsigned int reads, unsigned int writes, bool mainThread,
+	const std::function<void()>& func);
+void TaskGraphRun(TaskGraph* pGraph);
+
+// Print the average time of each node and the critical path since the last report
+void TaskGraphReport(TaskGraph* pGraph);
+void TaskGraphEnableReport(int numRun);		// Every graph prints its report every numRun runs, 0 = never
+
+
+#endif // TASK_GRAPH
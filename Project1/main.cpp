@@ -4,13 +4,28 @@
 //				press R to restart the level
 //				press N to change the level
 //				press esc to quit
+//				run with --bench to measure the game object pool and quit
+//				run with --asteroids N to start level 1 with N asteroids
+//				run with --broadphase loop|grid|sap|tree to pick how level 1 finds the collision pairs (default loop, grid from 80 asteroids)
+//				run with --tickrate N to update the game N times per second (default 60)
+//				run with --threads N to update the game on N threads (default one per core)
+//				run with --aibudget N to let the AI steer N missiles per update (default 8192, 0 = no limit)
+//				run with --taskgraph N to print the time of the frame phases every N frames
+//				run with --headless [N] to run N frames (default 10000) of level 1 with no window and quit
+//				run with --seed N to get the same asteroid field in every run
+//				run with --record file to save the keys of every update, with --replay file to play them again
+//				(same seed, tick rate, asteroids and AI budget), --headless --replay file compares the frame cost of two builds
+//				the CMake build (Linux) has no window, it runs --headless and --bench only
 // ---------------------------------------------------------------------------
 
 
 // Include standard headers
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <vector>
+#include <chrono>
+#include <algorithm>
 
 // Include GLEW
 #include <GL/glew.h>
@@ -24,7 +39,12 @@ GLFWwindow* window;
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "system.h"
+#include "AIScheduler.h"
 #include "CDT.h"
+#include "GameInput.h"
+#include "GameRandom.h"
+#include "JobSystem.h"
+#include "TaskGraph.h"
 #include "GameStateLevel1.h"
 #include "GameStateLevel2.h"
 
@@ -41,29 +61,311 @@ unsigned int	gGameStateNext;
 void(*GameStateLoad)()						= 0;
 void(*GameStateInit)()						= 0;
 void(*GameStateUpdate)(double,long,int&)	= 0;
-void(*GameStateDraw)()						= 0;
+void(*GameStateDraw)(double)				= 0;
 void(*GameStateFree)()						= 0;
 void(*GameStateUnload)()					= 0;
 
 // key manager, for one time pressing
-bool Rdown = false;
 bool Sdown = false;
-bool Ndown = false;
 
 // frame rate
 double	frametime = 0;
 long	framenumber = 0;
 
+// fixed time step
+//	- Update() always gets the same dt, it runs 0..MAX_TICK_PER_FRAME times per rendered frame
+//	- framenumber counts the updates since the level was (re)started, so frame % n is also independent
+//	  of the frame rate, the window and the headless run reset it the same way
+#define MAX_TICK_PER_FRAME	5
+double	tickrate = 60.0;
+double	tick = 1.0 / 60.0;
+double	accumulator = 0;
+
 // windows
 int		win_width = 1024;
 int		win_height = 768;
 
+// threads for the job system, 0 = one per core
+int		numthread = 0;
+
+// headless run, no window/GL, 0 frames = 10000 or the length of the replay
+bool	headless = false;
+long	headlessframe = 0;
+
+// input recording, NULL = none
+const char*	recordfile = NULL;
+const char*	replayfile = NULL;
+
+
+// -------------------------------------------
+// Game states, the same for the window and the headless run
+// -------------------------------------------
+
+// Load the level of gGameStateCurr, or go back to the previous one on RESTART
+void GameStateEnter(){
+
+	if (gGameStateCurr == RESTART){
+		gGameStateCurr = gGameStatePrev;
+		gGameStateNext = gGameStateCurr;
+	}
+	else if (gGameStateCurr == LEVEL2){
+		GameStateLoad	= GameStateLevel2Load;
+		GameStateInit	= GameStateLevel2Init;
+		GameStateUpdate = GameStateLevel2Update;
+		GameStateDraw	= GameStateLevel2Draw;
+		GameStateFree	= GameStateLevel2Free;
+		GameStateUnload = GameStateLevel2Unload;
+		GameStateLoad();
+	}
+	else{	//LEVEL1
+		GameStateLoad	= GameStateLevel1Load;
+		GameStateInit	= GameStateLevel1Init;
+		GameStateUpdate = GameStateLevel1Update;
+		GameStateDraw	= GameStateLevel1Draw;
+		GameStateFree	= GameStateLevel1Free;
+		GameStateUnload = GameStateLevel1Unload;
+		GameStateLoad();
+	}
+
+	GameStateInit();
+	framenumber = 0;
+}
+
+// Free the level, unload it unless it restarts, and move on to gGameStateNext
+void GameStateLeave(){
+
+	GameStateFree();
+
+	if (gGameStateNext != RESTART){
+		GameStateUnload();
+	}
+
+	gGameStatePrev = gGameStateCurr;
+	gGameStateCurr = gGameStateNext;
+}
+
+// One update of the current level with the input of this update
+//	- R (restart) and N (level change) come from GameInput like the other keys, so they are
+//	  recorded and a replay restarts and changes level after the same updates
+//	- returns 1 when the game state changes
+int GameStateTick(){
+
+	int state = 0;
+	framenumber++;
+	GameInputUpdate(framenumber);
+	GameStateUpdate(tick, framenumber, state);
+
+	// out of lives or R: restart the level
+	if (state == 2 || GameInputPressed(GLFW_KEY_R)){
+		gGameStateNext = RESTART;
+	}
+	// N: change level
+	else if (GameInputPressed(GLFW_KEY_N)){
+		gGameStateNext = (gGameStateCurr == LEVEL1) ? LEVEL2 : LEVEL1;
+	}
+	return gGameStateNext != gGameStateCurr;
+}
+
+
+// -------------------------------------------
+// Phases of a frame, the nodes of the frame task graph
+// -------------------------------------------
+
+enum{ RES_EVENTS = 1 << 0, RES_WORLD = 1 << 1, RES_SCREEN = 1 << 2 };
+
+void FrameInput(){
+
+	// read input
+	SystemPollEvents();
+
+	// Check if the ESC key was pressed or the window was closed
+	if (SystemKeyDown(GLFW_KEY_ESCAPE) || SystemWindowClosed()){
+		gGameStateNext = QUIT;
+	}
+}
+
+void FrameUpdate(){
+
+	// consume the elapsed time in fixed steps, stop at the first change of game state
+	while (accumulator >= tick && gGameStateNext == gGameStateCurr){
+		GameStateTick();
+		accumulator -= tick;
+	}
+
+	// nothing left to replay
+	if (GameInputEnd()){
+		gGameStateNext = QUIT;
+	}
+}
+
+void FrameDraw(){
+
+	// draw between the last two updates
+	//	- the tick loop stops early on a change of state, the time left over may be more than a tick
+	GameStateDraw(glm::clamp(accumulator / tick, 0.0, 1.0));
+}
+
+
+// -------------------------------------------
+// Headless: the levels with the stub (or replayed) input and no renderer, as fast as it goes
+//	- the same game states as the window, the level starts at level 1
+// -------------------------------------------
+
+int RunHeadless(long numFrame){
+
+	CDTInitHeadless(win_width, win_height);
+	JobSystemInit(numthread);
+	if (replayfile == NULL){
+		GameInputInit(INPUT_STUB);
+	}
+
+	// per frame times, the spikes matter as much as the average
+	std::vector<float> frameMs;
+	frameMs.reserve(numFrame);
+
+	gGameStateCurr	= LEVEL1;
+	gGameStatePrev	= LEVEL1;
+	gGameStateNext	= LEVEL1;
+
+	int numRestart = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (gGameStateCurr != QUIT){
+		GameStateEnter();
+
+		while (gGameStateCurr == gGameStateNext){
+			if ((long)frameMs.size() >= numFrame || GameInputEnd()){
+				gGameStateNext = QUIT;
+				break;
+			}
+
+			auto frameStart = std::chrono::steady_clock::now();
+			GameStateTick();
+			frameMs.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+		}
+
+		if (gGameStateNext == RESTART){
+			numRestart++;
+		}
+		GameStateLeave();
+	}
+	auto stop = std::chrono::steady_clock::now();
+
+	numFrame = (long)frameMs.size();
+	double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+	printf("Headless: %ld frames in %.1f ms, %.3f ms per frame, %.0f frames per second, %d restarts\n",
+		numFrame, ms, ms / numFrame, numFrame * 1000.0 / ms, numRestart);
+
+	if (numFrame > 0){
+		std::sort(frameMs.begin(), frameMs.end());
+		printf("Headless: frame ms p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n",
+			frameMs[numFrame / 2], frameMs[numFrame * 9 / 10], frameMs[numFrame * 99 / 100], frameMs[numFrame - 1]);
+	}
+
+	GameInputClose();
+	JobSystemShutdown();
+	CDTShutdown();
+
+	return 0;
+}
+
+
+int main(int argc, char* argv[]){
+
+	// Benchmarks run without any window
+	for (int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "--bench") == 0){
+			GameStateLevel1Benchmark();
+			return 0;
+		}
+		if (strcmp(argv[i], "--asteroids") == 0 && i + 1 < argc){
+			GameStateLevel1SetNumAsteroid(atoi(argv[++i]));
+		}
+		if (strcmp(argv[i], "--broadphase") == 0 && i + 1 < argc){
+			if (!GameStateLevel1SetBroadphase(argv[++i])){
+				fprintf(stderr, "Unknown broadphase %s\n", argv[i]);
+				return 1;
+			}
+		}
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+			numthread = atoi(argv[++i]);
+		}
+		if (strcmp(argv[i], "--aibudget") == 0 && i + 1 < argc){
+			AISchedulerSetBudget(atoi(argv[++i]));
+		}
+		if (strcmp(argv[i], "--headless") == 0){
+			headless = true;
+			if (i + 1 < argc && argv[i + 1][0] >= '0' && argv[i + 1][0] <= '9'){
+				headlessframe = atol(argv[++i]);
+			}
+		}
+		if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+			GameRandomSetSeed(strtoull(argv[++i], NULL, 10));
+		}
+		if (strcmp(argv[i], "--taskgraph") == 0 && i + 1 < argc){
+			TaskGraphEnableReport(atoi(argv[++i]));
+		}
+		if (strcmp(argv[i], "--tickrate") == 0 && i + 1 < argc){
+			tickrate = atof(argv[++i]);
+			if (tickrate <= 0.0){
+				tickrate = 60.0;
+			}
+		}
+		if (strcmp(argv[i], "--record") == 0 && i + 1 < argc){
+			recordfile = argv[++i];
+		}
+		if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc){
+			replayfile = argv[++i];
+		}
+	}
+
+	// a replay runs with the settings of its recording, whatever the command line says
+	if (replayfile != NULL){
+		GameInputHeader header;
+		if (!GameInputReplay(replayfile, header)){
+			fprintf(stderr, "Cannot replay %s\n", replayfile);
+			return 1;
+		}
+		GameRandomSetSeed(header.seed);
+		GameStateLevel1SetNumAsteroid(header.numAsteroid);
+		AISchedulerSetBudget(header.aiBudget);
+		tickrate = header.tickrate;
+		if (headlessframe == 0){
+			headlessframe = GameInputNumFrame();
+		}
+	}
+	tick = 1.0 / tickrate;
+
+	if (recordfile != NULL){
+		GameInputHeader header;
+		header.seed = GameRandomGetSeed();
+		header.tickrate = tickrate;
+		header.numAsteroid = GameStateLevel1GetNumAsteroid();
+		header.aiBudget = AISchedulerGetBudget();
+		if (!GameInputRecord(recordfile, header)){
+			fprintf(stderr, "Cannot record to %s\n", recordfile);
+			return 1;
+		}
+	}
 
-int main(void){
+	if (headless){
+		return RunHeadless(headlessframe > 0 ? headlessframe : 10000);
+	}
 
 	// Initialize the System (GFW, GLEW, Input, Create window)
-	SystemInit(win_width, win_height, "Asteroid Demo");
+	if (SystemInit(win_width, win_height, "Asteroid Demo") != 0){
+		return 1;
+	}
 	CDTInit(win_width, win_height);
+	JobSystemInit(numthread);
+	if (replayfile == NULL){
+		GameInputInit(INPUT_LIVE);
+	}
+
+	// the GL calls and the input must stay on this thread
+	TaskGraph* pFrame = TaskGraphCreate("frame");
+	TaskGraphAdd(pFrame, "input", 0, RES_EVENTS, true, FrameInput);
+	TaskGraphAdd(pFrame, "update", RES_EVENTS, RES_WORLD, true, FrameUpdate);
+	TaskGraphAdd(pFrame, "draw", RES_WORLD, RES_SCREEN, true, FrameDraw);
 
 	// Initialize Game State (to level 1)
 	gGameStateInit	= LEVEL1;
@@ -74,90 +376,31 @@ int main(void){
 	while(gGameStateCurr != QUIT){
 		
 		// Loading cases
-		if (gGameStateCurr == RESTART){
-			gGameStateCurr = gGameStatePrev;
-			gGameStateNext = gGameStateCurr;
-		}
-		else if (gGameStateCurr == LEVEL2){
-			GameStateLoad	= GameStateLevel2Load;
-			GameStateInit	= GameStateLevel2Init;
-			GameStateUpdate = GameStateLevel2Update;
-			GameStateDraw	= GameStateLevel2Draw;
-			GameStateFree	= GameStateLevel2Free;
-			GameStateUnload = GameStateLevel2Unload;
-			GameStateLoad();
-		}
-		else{	//LEVEL1
-			GameStateLoad	= GameStateLevel1Load;
-			GameStateInit	= GameStateLevel1Init;
-			GameStateUpdate = GameStateLevel1Update;
-			GameStateDraw	= GameStateLevel1Draw;
-			GameStateFree	= GameStateLevel1Free;
-			GameStateUnload = GameStateLevel1Unload;
-			GameStateLoad();
-		}
-		
+		GameStateEnter();
 		FrameInit();
-		GameStateInit();
-		framenumber = 0;
+		accumulator = 0;
 		
 
 		while (gGameStateCurr == gGameStateNext){
 			
+			// a long frame (breakpoint, window drag) is dropped instead of being caught up
 			frametime = FrameStart();
-			framenumber++;
-
-			// read input
-			glfwPollEvents();
+			accumulator += glm::min(frametime, MAX_TICK_PER_FRAME * tick);
 
-			int state = 0;
-			GameStateUpdate(frametime, framenumber, state);
-			GameStateDraw();
-
-			// Check return state from Update()
-			if (state == 2){
-				gGameStateNext = RESTART;
-			}
-			
-
-			// Check if the ESC key was pressed or the window was closed
-			if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS || glfwWindowShouldClose(window) == 1){
-				gGameStateNext = QUIT;
-			}
-
-			// Check if User want to restart level
-			if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && !Rdown){
-				gGameStateNext = RESTART;
-				Rdown = true;
-			}
-			if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE && Rdown){Rdown = false;}
-
-			// Check if User want to change level
-			if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS && !Ndown){
-				if (gGameStateCurr == LEVEL1){
-					gGameStateNext = LEVEL2;
-				}else{
-					gGameStateNext = LEVEL1;
-				}
-				Ndown = true;
-			}
-			if (glfwGetKey(window, GLFW_KEY_N) == GLFW_RELEASE && Ndown){ Ndown = false; }
+			// input -> update -> draw, the level runs its own graph inside update and draw
+			TaskGraphRun(pFrame);
 
 			FrameEnd();
 		}
 
-		GameStateFree();
-
-		if (gGameStateNext != RESTART){
-			GameStateUnload();
-		}
-
-		gGameStatePrev = gGameStateCurr;
-		gGameStateCurr = gGameStateNext;
+		GameStateLeave();
 	} 
 
 
 	// Do system clean up before quit
+	GameInputClose();
+	TaskGraphDestroy(pFrame);
+	JobSystemShutdown();
 	CDTShutdown();
 	SystemShutdown();
 	
@@ -46,7 +46,7 @@ int SystemInit(int width, int height, const char* title){
 	glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
 
 	printf("System succesfully initialize\n");
-
+	return 0;
 }
 
 void SystemShutdown(){
@@ -58,6 +58,27 @@ void SystemShutdown(){
 
 
 
+// ---------------------------------------------------------------------------
+// Window & input
+
+void SystemPollEvents(){
+	glfwPollEvents();
+}
+
+bool SystemKeyDown(int key){
+	return glfwGetKey(window, key) == GLFW_PRESS;
+}
+
+bool SystemWindowClosed(){
+	return glfwWindowShouldClose(window) == 1;
+}
+
+void SystemSwapBuffers(){
+	glfwSwapBuffers(window);
+}
+
+
+
 // ---------------------------------------------------------------------------
 // Get frame duration between each frame
 
@@ -19,6 +19,13 @@ int SystemInit(int width, int height, const char* title);
 
 void SystemShutdown();
 
+// Window & input, the game calls these instead of GLFW
+//	- systemHeadless.cpp has the same functions with no window, for the build without GL (GAME_HEADLESS)
+void SystemPollEvents();
+bool SystemKeyDown(int key);			// GLFW_KEY_*, held in the window
+bool SystemWindowClosed();
+void SystemSwapBuffers();
+
 // Get frame duration between each frame
 void FrameInit();
 double FrameStart();
@@ -0,0 +1,64 @@
+
+
+#include "system.h"
+#include <chrono>
+
+// ---------------------------------------------------------------------------
+// system.cpp for the build without GL (GAME_HEADLESS, the headless target of CMakeLists.txt)
+//	- no window: SystemInit() fails, this build runs --headless and --bench only
+//	- no GLFW either, the frame clock is std::chrono
+
+typedef std::chrono::steady_clock	SystemClock;
+
+SystemClock::time_point prevTime;
+SystemClock::time_point currTime;
+
+
+// ---------------------------------------------------------------------------
+// Initialize
+
+int SystemInit(int /*width*/, int /*height*/, const char* /*title*/){
+
+	fprintf(stderr, "No window in the headless build, run with --headless or --bench\n");
+	return -1;
+}
+
+void SystemShutdown(){
+}
+
+
+
+// ---------------------------------------------------------------------------
+// Window & input, no window: no key, never closed
+
+void SystemPollEvents(){
+}
+
+bool SystemKeyDown(int /*key*/){
+	return false;
+}
+
+bool SystemWindowClosed(){
+	return false;
+}
+
+void SystemSwapBuffers(){
+}
+
+
+
+// ---------------------------------------------------------------------------
+// Get frame duration between each frame
+
+void FrameInit(){
+	prevTime = SystemClock::now();
+}
+
+double FrameStart(){
+	currTime = SystemClock::now();
+	return std::chrono::duration<double>(currTime - prevTime).count();
+}
+
+void FrameEnd(){
+	prevTime = currTime;
+}